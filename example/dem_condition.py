@@ -4,17 +4,9 @@
 DEM Conditioning Script
 Make the Digital Elevation Model
 Hydrologically Consistent for Drainage
-
-Note: Currently using PySheds!
 '''
 
-from pysheds.grid import Grid
-import numpy as np
-import matplotlib.pyplot as plt
-from matplotlib import colors
 import soillib as soil
-import rasterio
-import math
 
 '''
 Main Control Flow
@@ -24,42 +16,25 @@ def main(filename, file_out):
 
   print(f"Loading DEM ({filename})...")
 
-  grid = Grid.from_raster(filename)
-  dem = grid.read_raster(filename)
+  t = soil.geotiff(filename)
 
-  print("Conditioning DEM...")
+  # Note: This has to be double precision,
+  # because the raised cells differ from their
+  # spill cells by a single unit in the last place.
+  # With single precision, large flats are raised
+  # by a noticeable amount.
 
-  with soil.timer() as timer:
+  array = soil.cast(t.buffer, soil.float64)
+  index = t.index
 
-    dem.nodata = np.nan
-    dem = grid.fill_pits(dem)
-    dem = grid.fill_depressions(dem)
-    dem = grid.resolve_flats(dem)
+  print("Conditioning DEM...")
 
-    dem = grid.fill_pits(dem)
-    dem = grid.fill_depressions(dem)
-    dem = grid.resolve_flats(dem)
+  with soil.timer() as timer:
+    array = soil.condition(array, index)
 
   print("Saving DEM...")
 
-  # Note: Make this construction easier!
-  # Note: This has to be double precision,
-  # because the correction algorithms use double precision.
-  # If you don't do this, accuracy is lost and the state
-  # is not accurately reproduced for flow direction purposes.
-
-  shape = soil.index(dem.shape)
-  array = soil.buffer(soil.float64, shape.elem())
-  soil.set(array, np.nan)
-
-  for x in range(shape[0]):
-    for y in range(shape[1]):
-      array[x*shape[1]+y] = dem[x,y]
-
-  t = soil.geotiff()
-  t.peek(filename)
-
-  tiff_out = soil.geotiff(array, shape)
+  tiff_out = soil.geotiff(array, index)
   tiff_out.meta = t.meta
   tiff_out.unsetnan()
   tiff_out.write(file_out)
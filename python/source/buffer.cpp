@@ -10,6 +10,7 @@ namespace nb = nanobind;
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/stl/optional.h>
+#include <nanobind/stl/map.h>
 
 #include <soillib/util/timer.hpp>
 #include <soillib/core/types.hpp>
@@ -21,10 +22,24 @@ namespace nb = nanobind;
 #include <soillib/op/math.hpp>
 
 #include "glm.hpp"
+#include "half.hpp"
 
 template<typename T> struct make_numpy; //!< Buffer to Numpy Exporter
 template<typename T> struct make_torch; //!< Buffer to PyTorch Exporter
 
+//! Python Context Manager for buffer_track Scopes
+struct track_scope_t {
+  track_scope_t(const std::string& name):name{name}{}
+  std::string name;
+};
+
+//! Python Context Manager for buffer_map Scopes
+struct map_scope_t {
+  map_scope_t(const std::string& directory, const soil::advice_t advice):directory{directory},advice{advice}{}
+  std::string directory;
+  soil::advice_t advice;
+};
+
 //
 //
 //
@@ -43,10 +58,68 @@ nb::enum_<soil::host_t>(module, "host")
   .value("gpu", soil::host_t::GPU)
   .export_values();
 
+// File-Backed Buffer Access Hint
+
+nb::enum_<soil::advice_t>(module, "advice")
+  .value("normal", soil::advice_t::NORMAL)
+  .value("sequential", soil::advice_t::SEQUENTIAL)
+  .value("random", soil::advice_t::RANDOM);
+
 // Memory Consumption Counters
 
-module.def("mem_cpu", [](){ return soil::buffer_track::mem_cpu; });
-module.def("mem_gpu", [](){ return soil::buffer_track::mem_gpu; });
+module.def("mem_cpu", [](){ return soil::buffer_track::mem_cpu.current.load(); });
+module.def("mem_gpu", [](){ return soil::buffer_track::mem_gpu.current.load(); });
+
+auto track_stats = nb::class_<soil::buffer_track::stats_t>(module, "track_stats");
+track_stats.def_ro("current", &soil::buffer_track::stats_t::current);
+track_stats.def_ro("peak", &soil::buffer_track::stats_t::peak);
+track_stats.def_ro("allocs", &soil::buffer_track::stats_t::allocs);
+track_stats.def_ro("frees", &soil::buffer_track::stats_t::frees);
+
+auto track_snapshot = nb::class_<soil::buffer_track::snapshot_t>(module, "track_snapshot");
+track_snapshot.def_ro("cpu", &soil::buffer_track::snapshot_t::cpu);
+track_snapshot.def_ro("gpu", &soil::buffer_track::snapshot_t::gpu);
+track_snapshot.def_ro("tags", &soil::buffer_track::snapshot_t::tags);
+
+module.def("track", &soil::buffer_track::snapshot);
+module.def("track_reset", &soil::buffer_track::reset);
+
+// Allocation Scope: with soil.track_scope("name"): ...
+
+auto track_scope = nb::class_<track_scope_t>(module, "track_scope");
+track_scope.def(nb::init<const std::string&>());
+track_scope.def("__enter__", [](track_scope_t& scope) -> track_scope_t& {
+  soil::buffer_track::push(scope.name);
+  return scope;
+}, nb::rv_policy::reference);
+track_scope.def("__exit__", [](track_scope_t& scope, nb::args){
+  soil::buffer_track::pop();
+});
+
+// Allocation Policy: with soil.map_scope(directory): ... (File-Backed)
+
+auto map_scope = nb::class_<map_scope_t>(module, "map_scope");
+map_scope.def(nb::init<const std::string&, const soil::advice_t>(),
+  nb::arg("directory") = "", nb::arg("advice") = soil::advice_t::NORMAL);
+map_scope.def("__enter__", [](map_scope_t& scope) -> map_scope_t& {
+  soil::buffer_map::push(scope.directory, scope.advice);
+  return scope;
+}, nb::rv_policy::reference);
+map_scope.def("__exit__", [](map_scope_t& scope, nb::args){
+  soil::buffer_map::pop();
+});
+
+// Host Memory Pool Statistics
+
+auto pool_stats = nb::class_<soil::host_pool::stats_t>(module, "pool_stats");
+pool_stats.def_ro("hits", &soil::host_pool::stats_t::hits);
+pool_stats.def_ro("misses", &soil::host_pool::stats_t::misses);
+pool_stats.def_ro("cached", &soil::host_pool::stats_t::cached);
+pool_stats.def_ro("blocks", &soil::host_pool::stats_t::blocks);
+
+module.def("pool", [](){ return soil::host_pool::get().stats(); });
+module.def("pool_release", [](){ soil::host_pool::get().release(); });
+module.def("pool_limit", [](const size_t limit){ soil::host_pool::get().limit = limit; });
 
 // Buffer Type
 
@@ -55,10 +128,17 @@ buffer.def(nb::init<>());
 buffer.def(nb::init<const soil::dtype, const size_t>());
 buffer.def(nb::init<const soil::dtype, const size_t, const soil::host_t>());
 
+// File-Backed Buffer: Empty Filename uses a Temporary File
+
+buffer.def_static("mapped", [](const soil::dtype type, const size_t size, const std::string& filename, const soil::advice_t advice){
+  return soil::buffer::mapped(type, size, filename.c_str(), advice);
+}, nb::arg("type"), nb::arg("size"), nb::arg("filename") = "", nb::arg("advice") = soil::advice_t::NORMAL);
+
 buffer.def_prop_ro("type", &soil::buffer::type);
 buffer.def_prop_ro("elem", &soil::buffer::elem);
 buffer.def_prop_ro("size", &soil::buffer::size);
 buffer.def_prop_ro("host", &soil::buffer::host);
+buffer.def_prop_ro("readonly", &soil::buffer::readonly);
 
 // Device-Switching Functions:
 // Return a Copy of the Buffer Directly
@@ -103,6 +183,9 @@ buffer.def("__setitem__", [](soil::buffer& buffer, const nb::slice& slice, const
   if(PySlice_GetIndices(slice.ptr(), elem, &start, &stop, &step) != 0)
     throw std::runtime_error("slice is invalid!");
 
+  if(buffer.readonly())
+    throw std::invalid_argument("buffer is read-only");
+
   soil::select(buffer.type(), [&]<typename S>(){
     auto buffer_t = buffer.as<S>();           // Assignable Strict-Type Buffer
     const auto value_t = nb::cast<S>(value);  // Assignable Value
@@ -164,34 +247,29 @@ buffer.def_static("from_numpy", [](const nb::object& object){
 
   auto array = nb::cast<nb::ndarray<nb::numpy>>(object);
 
-  if(array.dtype() == nb::dtype<float>()){
-
-    const size_t size = array.size();
-    const float* data = (float*)array.data();
-    auto buffer_t = soil::buffer_t<float>(size, soil::host_t::CPU);
-
-    for(size_t i = 0; i < size; ++i)
-      buffer_t[i] = data[i];
-
-    return std::move(soil::buffer(std::move(buffer_t)));
-
-  }
-  
-  else if(array.dtype() == nb::dtype<double>()){
-
+  const auto copy = [&array]<typename T>() -> soil::buffer {
     const size_t size = array.size();
-    const double* data = (double*)array.data();
-    auto buffer_t = soil::buffer_t<double>(size, soil::host_t::CPU);
-
-    for(size_t i = 0; i < size; ++i)
-      buffer_t[i] = data[i];
-
-    return std::move(soil::buffer(std::move(buffer_t)));
-
-  }
-  else {
-    throw std::runtime_error("type not supported");
-  }
+    auto buffer_t = soil::buffer_t<T>(size, soil::host_t::CPU);
+    std::memcpy(buffer_t.data(), array.data(), size * sizeof(T));
+    return soil::buffer(std::move(buffer_t));
+  };
+
+  if(array.dtype() == nb::dtype<float>())
+    return copy.template operator()<float>();
+  if(array.dtype() == nb::dtype<double>())
+    return copy.template operator()<double>();
+  if(array.dtype() == nb::dtype<int>())
+    return copy.template operator()<int>();
+  if(array.dtype() == nb::dtype<uint8_t>())
+    return copy.template operator()<uint8_t>();
+  if(array.dtype() == nb::dtype<int16_t>())
+    return copy.template operator()<int16_t>();
+  if(array.dtype() == nb::dtype<uint16_t>())
+    return copy.template operator()<uint16_t>();
+  if(array.dtype() == nb::dtype<soil::half>())
+    return copy.template operator()<soil::half>();
+
+  throw std::runtime_error("type not supported");
 
 });
 
@@ -211,16 +289,22 @@ struct make_numpy {
 
     soil::buffer_t<T> source = buffer.as<T>();
 
+    // Note: Read-only memory (e.g. of a read-only archive) is
+    //  exported as a read-only array, since writes would fault.
+
+    const auto make = [&]<typename V, size_t N>(const size_t* shape) -> nb::object {
+      if(source.readonly()){
+        nb::ndarray<nb::numpy, const V, nb::ndim<N>> array((const V*)source.data(), N, shape, nb::find(buffer));
+        return nb::cast(std::move(array));
+      }
+      nb::ndarray<nb::numpy, V, nb::ndim<N>> array((V*)source.data(), N, shape, nb::find(buffer));
+      return nb::cast(std::move(array));
+    };
+
     if constexpr(nb::detail::is_ndarray_scalar_v<T>){
 
       size_t shape[1] = { source.elem() };
-      nb::ndarray<nb::numpy, T, nb::ndim<1>> array(
-        source.data(),    // raw data pointer
-        1,                // number of dimensions
-        shape,            // shape of array
-        nb::find(buffer)  // lifetime guarantee
-      );
-      return nb::cast(std::move(array));
+      return make.template operator()<T, 1>(shape);
 
     } else {
       //! \todo add a concept to explicitly test for vector types
@@ -229,13 +313,7 @@ struct make_numpy {
       using V = soil::typedesc<T>::value_t;
 
       size_t shape[2] = { source.elem(), D };
-      nb::ndarray<nb::numpy, V, nb::ndim<D>> array(
-        source.data(),
-        2,
-        shape,
-        nb::find(buffer)
-      );
-      return nb::cast(std::move(array));
+      return make.template operator()<V, 2>(shape);
 
     }
 
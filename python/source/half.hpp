@@ -0,0 +1,46 @@
+#ifndef SOILLIB_PYTHON_HALF
+#define SOILLIB_PYTHON_HALF
+
+//! Half-Precision Type Caster
+//!
+//! soil::half is exported to numpy as float16, and
+//! is cast to and from python floats by value.
+
+#include <nanobind/ndarray.h>
+#include <soillib/core/half.hpp>
+
+namespace nanobind {
+namespace detail {
+
+template<>
+struct dtype_traits<soil::half> {
+	static constexpr dlpack::dtype value{
+		(uint8_t)dlpack::dtype_code::Float, // Type Code
+		16,                                  // Size in Bits
+		1                                    // Lanes
+	};
+	static constexpr auto name = const_name("float16");
+};
+
+template<>
+struct type_caster<soil::half> {
+
+	NB_TYPE_CASTER(soil::half, const_name("float"))
+
+	bool from_python(handle src, uint8_t flags, cleanup_list *cleanup) noexcept {
+		make_caster<float> caster;
+		if (!caster.from_python(src, flags, cleanup))
+			return false;
+		value = soil::half(caster.value);
+		return true;
+	}
+
+	static handle from_cpp(const soil::half src, rv_policy, cleanup_list *) noexcept {
+		return PyFloat_FromDouble(double(float(src)));
+	}
+};
+
+}	// end of namespace detail
+}	// end of namespace nanobind
+
+#endif
@@ -19,6 +19,7 @@ namespace nb = nanobind;
 #include <soillib/core/buffer.hpp>
 
 #include "glm.hpp"
+#include "half.hpp"
 
 //
 //
@@ -33,6 +34,8 @@ nb::enum_<soil::dindex>(module, "dindex")
   .value("flat3", soil::dindex::FLAT3)
   .value("flat4", soil::dindex::FLAT4)
   .value("quad", soil::dindex::QUAD)
+  .value("morton", soil::dindex::MORTON)
+  .value("tiled2", soil::dindex::TILED2)
   .export_values();
 
 //
@@ -52,6 +55,18 @@ index.def("__init__", [](soil::index* index, const std::vector<std::tuple<soil::
   new (index) soil::index(data);
 });
 
+// Strict-Typed Layout Constructors
+//  Note: flow, direction and condition accept a tiled layout, while the
+//  graph based flow operations require a flat layout (see soil.reorder).
+
+index.def_static("morton", [](const soil::ivec2 ext){
+  return soil::index(soil::morton_t(ext));
+});
+
+index.def_static("tiled", [](const soil::ivec2 ext, const soil::ivec2 tile){
+  return soil::index(soil::tiled_t<2>(ext, tile));
+});
+
 index.def_prop_ro("type", &soil::index::type);
 index.def("dims", &soil::index::dims);
 index.def("elem", &soil::index::elem);
@@ -84,7 +99,7 @@ index.def("iter", [](soil::index& index) -> nb::object {
     auto iter = index.as<T>().iter();
     return nb::cast(std::move(iter));
   });
-});
+}, nb::keep_alive<0, 1>());
 
 // note: necessary for floating point positions!
 // note: has to be defined first for higher priority
@@ -7,14 +7,33 @@ namespace nb = nanobind;
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 
+#include <soillib/io/archive.hpp>
 #include <soillib/io/tiff.hpp>
 #include <soillib/io/geotiff.hpp>
 #include <soillib/io/mesh.hpp>
+#include <soillib/io/mosaic.hpp>
 
 #include "glm.hpp"
+#include "half.hpp"
 
 void bind_io(nb::module_& module){
 
+//! TIFF Writer Options
+
+nb::enum_<soil::io::compress_t>(module, "compress_t")
+  .value("none", soil::io::compress_t::NONE)
+  .value("lzw", soil::io::compress_t::LZW)
+  .value("deflate", soil::io::compress_t::DEFLATE)
+  .value("zstd", soil::io::compress_t::ZSTD);
+
+auto options = nb::class_<soil::io::tiff::options_t>(module, "tiff_options");
+options.def(nb::init<>());
+options.def_rw("tile", &soil::io::tiff::options_t::tile);
+options.def_rw("compress", &soil::io::tiff::options_t::compress);
+options.def_rw("predictor", &soil::io::tiff::options_t::predictor);
+options.def_rw("bigtiff", &soil::io::tiff::options_t::bigtiff);
+options.def_rw("overviews", &soil::io::tiff::options_t::overviews);
+
 //! TIFF Datatype
 
 auto tiff = nb::class_<soil::io::tiff>(module, "tiff");
@@ -26,11 +45,25 @@ tiff.def("__init__", [](soil::io::tiff* tiff, const soil::buffer& buffer, const
 });
 
 tiff.def("peek", &soil::io::tiff::peek);
-tiff.def("read", &soil::io::tiff::read);
-tiff.def("write", &soil::io::tiff::write);
+tiff.def("read", [](soil::io::tiff& tiff, const char* filename){
+  return tiff.read(filename);
+});
+tiff.def("read", [](soil::io::tiff& tiff, const char* filename, const soil::ivec2 min, const soil::ivec2 ext){
+  return tiff.read(filename, min, ext);
+}, nb::arg("filename"), nb::arg("min"), nb::arg("ext"));
+tiff.def("read", [](soil::io::tiff& tiff, const char* filename, const size_t level){
+  return tiff.read(filename, level);
+}, nb::arg("filename"), nb::arg("level"));
+tiff.def("write", [](soil::io::tiff& tiff, const char* filename){
+  return tiff.write(filename);
+});
+tiff.def("write", [](soil::io::tiff& tiff, const char* filename, const soil::io::tiff::options_t& options){
+  return tiff.write(filename, options);
+}, nb::arg("filename"), nb::arg("options"));
 
 tiff.def_prop_ro("width", &soil::io::tiff::width);
 tiff.def_prop_ro("height", &soil::io::tiff::height);
+tiff.def_prop_ro("overviews", &soil::io::tiff::overviews);
 
 tiff.def_prop_ro("buffer", &soil::io::tiff::buffer, nb::rv_policy::reference_internal);
 tiff.def_prop_ro("index", &soil::io::tiff::index);//, nb::rv_policy::reference);
@@ -46,8 +79,21 @@ geotiff.def("__init__", [](soil::io::geotiff* geotiff, const soil::buffer& buffe
 });
 
 geotiff.def("peek", &soil::io::geotiff::peek);
-geotiff.def("read", &soil::io::geotiff::read);
-geotiff.def("write", &soil::io::geotiff::write);
+geotiff.def("read", [](soil::io::geotiff& geotiff, const char* filename){
+  return geotiff.read(filename);
+});
+geotiff.def("read", [](soil::io::geotiff& geotiff, const char* filename, const soil::ivec2 min, const soil::ivec2 ext){
+  return geotiff.read(filename, min, ext);
+}, nb::arg("filename"), nb::arg("min"), nb::arg("ext"));
+geotiff.def("read", [](soil::io::geotiff& geotiff, const char* filename, const size_t level){
+  return geotiff.read(filename, level);
+}, nb::arg("filename"), nb::arg("level"));
+geotiff.def("write", [](soil::io::geotiff& geotiff, const char* filename){
+  return geotiff.write(filename);
+});
+geotiff.def("write", [](soil::io::geotiff& geotiff, const char* filename, const soil::io::tiff::options_t& options){
+  return geotiff.write(filename, options);
+}, nb::arg("filename"), nb::arg("options"));
 
 geotiff.def_rw("meta", &soil::io::geotiff::_meta);
 
@@ -65,6 +111,48 @@ geotiff.def_prop_ro("scale", [](soil::io::geotiff& geotiff){
   return geotiff.scale();
 });
 
+//
+// GeoTIFF Mosaic
+//
+
+auto mosaic = nb::class_<soil::io::mosaic>(module, "mosaic");
+
+mosaic.def(nb::init<const std::vector<std::string>&, const size_t>(), nb::arg("files"), nb::arg("cache") = size_t(1) << 28);
+mosaic.def(nb::init<const char*, const size_t>(), nb::arg("directory"), nb::arg("cache") = size_t(1) << 28);
+
+mosaic.def("read", &soil::io::mosaic::read);
+
+mosaic.def_prop_ro("size", &soil::io::mosaic::size);
+mosaic.def_prop_ro("cached", &soil::io::mosaic::cached);
+mosaic.def_prop_ro("min", &soil::io::mosaic::min);
+mosaic.def_prop_ro("max", &soil::io::mosaic::max);
+mosaic.def_prop_ro("scale", &soil::io::mosaic::scale);
+mosaic.def_prop_ro("ext", &soil::io::mosaic::ext);
+
+//
+// Soil Archive (Memory Mapped)
+//
+
+nb::enum_<soil::io::access_t>(module, "access_t")
+  .value("readonly", soil::io::access_t::READONLY)
+  .value("copyonwrite", soil::io::access_t::COPYONWRITE);
+
+auto archive = nb::class_<soil::io::archive>(module, "archive");
+
+archive.def(nb::init<>());
+archive.def(nb::init<const char*, const soil::io::access_t>(), nb::arg("filename"), nb::arg("access") = soil::io::access_t::COPYONWRITE);
+
+archive.def("add", &soil::io::archive::add);
+archive.def("read", &soil::io::archive::read, nb::arg("filename"), nb::arg("access") = soil::io::access_t::COPYONWRITE);
+archive.def("write", &soil::io::archive::write);
+
+archive.def("names", &soil::io::archive::names);
+archive.def("has", &soil::io::archive::has);
+archive.def("buffer", &soil::io::archive::buffer);
+archive.def("index", &soil::io::archive::index);
+
+archive.def_rw("meta", &soil::io::archive::meta);
+
 //
 // Geotiff Metadata
 //
@@ -8,6 +8,9 @@ namespace nb = nanobind;
 
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/function.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
+#include <nanobind/stl/vector.h>
 
 #include <soillib/core/types.hpp>
 
@@ -17,10 +20,13 @@ namespace nb = nanobind;
 #include <soillib/op/flow.hpp>
 #include <soillib/op/math.hpp>
 #include <soillib/op/erosion.hpp>
+#include <soillib/op/expr.hpp>
+#include <soillib/op/pyramid.hpp>
 
 #include <iostream>
 
 #include "glm.hpp"
+#include "half.hpp"
 
 void bind_op(nb::module_& module){
 
@@ -32,8 +38,8 @@ module.def("cast", [](const soil::buffer& buf, const soil::dtype type){
   if(buf.type() == type){
     return nb::cast(buf);
   }
-  return soil::select(type, [&buf]<std::floating_point To>() -> nb::object {
-    return soil::select(buf.type(), [&buf]<std::floating_point From>() -> nb::object {
+  return soil::select(type, [&buf]<soil::scalar To>() -> nb::object {
+    return soil::select(buf.type(), [&buf]<soil::scalar From>() -> nb::object {
       soil::buffer buffer = soil::cast<To, From>(buf.as<From>());
       return nb::cast(buffer);
     });
@@ -52,6 +58,28 @@ module.def("max", [](const soil::buffer& buf){
   });
 });
 
+auto stats_t = nb::class_<soil::stats_t>(module, "stats_t");
+stats_t.def_ro("count", &soil::stats_t::count);
+stats_t.def_ro("nan", &soil::stats_t::nan);
+stats_t.def_ro("min", &soil::stats_t::min);
+stats_t.def_ro("max", &soil::stats_t::max);
+stats_t.def_ro("sum", &soil::stats_t::sum);
+stats_t.def_ro("mean", &soil::stats_t::mean);
+stats_t.def_ro("var", &soil::stats_t::var);
+stats_t.def_ro("hist_min", &soil::stats_t::hist_min);
+stats_t.def_ro("hist_max", &soil::stats_t::hist_max);
+stats_t.def_ro("hist", &soil::stats_t::hist);
+
+module.def("stats", [](const soil::buffer& buf, const size_t bins, const double lo, const double hi){
+  return soil::select(buf.type(), [&]<typename S>() -> soil::stats_t
+    requires soil::scalar<S>
+  {
+    return soil::stats(buf.as<S>(), bins, lo, hi);
+  });
+}, nb::arg("buffer"), nb::arg("bins") = 0,
+   nb::arg("lo") = std::numeric_limits<double>::quiet_NaN(),
+   nb::arg("hi") = std::numeric_limits<double>::quiet_NaN());
+
 //
 // Generic Buffer Functions
 //
@@ -77,6 +105,10 @@ module.def("set", [](soil::buffer& lhs, const soil::buffer& rhs){
   });
 });
 
+module.def("set", [](soil::buffer& buffer, const soil::expr& expr){
+  expr.evaluate(buffer);
+});
+
 module.def("set", [](soil::buffer& buffer, const nb::object value){
   soil::select(buffer.type(), [&buffer, &value]<typename S>(){
     auto buffer_t = buffer.as<S>();
@@ -117,14 +149,122 @@ module.def("multiply", [](soil::buffer& buffer, const nb::object value){
   });
 });
 
-module.def("resize", [](soil::buffer& lhs, const soil::buffer& rhs, soil::ivec2 out, soil::ivec2 in){
+module.def("resample", [](const soil::buffer& buffer, const soil::index& index){
+  return soil::select(buffer.type(), [&]<typename S>(){
+    return soil::buffer(soil::resample<S>(buffer.as<S>(), index));
+  });
+});
+
+module.def("reorder", [](const soil::buffer& buffer, const soil::index& index){
+  return soil::select(buffer.type(), [&]<typename S>(){
+    return soil::buffer(soil::reorder<S>(buffer.as<S>(), index));
+  });
+});
+
+nb::enum_<soil::resize_t>(module, "resize_t")
+  .value("bilinear", soil::resize_t::BILINEAR)
+  .value("bicubic", soil::resize_t::BICUBIC)
+  .value("area", soil::resize_t::AREA)
+  .export_values();
+
+module.def("resize", [](soil::buffer& lhs, const soil::buffer& rhs, soil::ivec2 out, soil::ivec2 in, const soil::resize_t filter){
   if(lhs.type() != rhs.type())
     throw soil::error::mismatch_type(lhs.type(), rhs.type());
-  soil::select(lhs.type(), [&lhs, &rhs, in, out]<typename S>(){
-    soil::resize<S>(lhs.as<S>(), rhs.as<S>(), out, in);
+  soil::select(lhs.type(), [&lhs, &rhs, in, out, filter]<typename S>(){
+    soil::resize<S>(lhs.as<S>(), rhs.as<S>(), out, in, filter);
   });
+}, nb::arg("lhs"), nb::arg("rhs"), nb::arg("out"), nb::arg("in"), nb::arg("filter") = soil::resize_t::BILINEAR);
+
+//
+// Lazy Expression Type
+//
+
+auto expr = nb::class_<soil::expr>(module, "expr");
+expr.def(nb::init_implicit<const soil::buffer&>());
+expr.def(nb::init_implicit<double>());
+
+expr.def_prop_ro("type", &soil::expr::type);
+expr.def_prop_ro("elem", &soil::expr::elem);
+
+expr.def("eval", [](const soil::expr& expr){
+  return expr.evaluate();
+});
+
+const auto bind_binary = [&expr](const char* name, const char* rname, const soil::expr::op_t op){
+  expr.def(name, [op](const soil::expr& lhs, const soil::expr& rhs){
+    return soil::expr::apply(op, {lhs, rhs});
+  });
+  if(rname != NULL)
+    expr.def(rname, [op](const soil::expr& lhs, const soil::expr& rhs){
+      return soil::expr::apply(op, {rhs, lhs});
+    });
+};
+
+bind_binary("__add__", "__radd__", soil::expr::ADD);
+bind_binary("__sub__", "__rsub__", soil::expr::SUB);
+bind_binary("__mul__", "__rmul__", soil::expr::MUL);
+bind_binary("__truediv__", "__rtruediv__", soil::expr::DIV);
+bind_binary("__pow__", "__rpow__", soil::expr::POW);
+bind_binary("__lt__", NULL, soil::expr::LT);
+bind_binary("__le__", NULL, soil::expr::LE);
+bind_binary("__gt__", NULL, soil::expr::GT);
+bind_binary("__ge__", NULL, soil::expr::GE);
+
+expr.def("__neg__", [](const soil::expr& expr){
+  return soil::expr::apply(soil::expr::SUB, {soil::expr(0.0), expr});
+});
+
+module.def("lazy", [](const soil::buffer& buffer){
+  return soil::expr(buffer);
+});
+
+module.def("minimum", [](const soil::expr& a, const soil::expr& b){
+  return soil::expr::apply(soil::expr::MIN, {a, b});
+});
+
+module.def("maximum", [](const soil::expr& a, const soil::expr& b){
+  return soil::expr::apply(soil::expr::MAX, {a, b});
+});
+
+module.def("pow", [](const soil::expr& a, const soil::expr& b){
+  return soil::expr::apply(soil::expr::POW, {a, b});
+});
+
+module.def("clamp", [](const soil::expr& a, const soil::expr& lo, const soil::expr& hi){
+  return soil::expr::apply(soil::expr::CLAMP, {a, lo, hi});
+});
+
+module.def("where", [](const soil::expr& c, const soil::expr& a, const soil::expr& b){
+  return soil::expr::apply(soil::expr::WHERE, {c, a, b});
+});
+
+module.def("is_nan", [](const soil::expr& a){
+  return soil::expr::apply(soil::expr::IS_NAN, {a});
 });
 
+module.def("fill_nan", [](const soil::expr& a, const soil::expr& value){
+  return soil::expr::apply(soil::expr::FILL_NAN, {a, value});
+});
+
+module.def("mask", [](const soil::expr& a, const soil::expr& mask){
+  return soil::expr::apply(soil::expr::MASK, {a, mask});
+});
+
+//
+// Resolution Pyramid Type
+//
+
+auto pyramid = nb::class_<soil::pyramid>(module, "pyramid");
+pyramid.def(nb::init<const soil::buffer&, const soil::index&, const size_t, const std::optional<double>>(),
+  nb::arg("buffer"), nb::arg("index"), nb::arg("levels") = 0, nb::arg("nodata") = nb::none());
+pyramid.def_prop_ro("levels", &soil::pyramid::levels);
+pyramid.def("index", [](const soil::pyramid& pyramid, const size_t level){
+  return soil::index(pyramid.index(level).ext());
+});
+pyramid.def("level", &soil::pyramid::level);
+pyramid.def("invalidate", &soil::pyramid::invalidate);
+pyramid.def("update", &soil::pyramid::update);
+
 //
 // Noise Sampler Type
 //
@@ -159,6 +299,7 @@ auto param_t = nb::class_<soil::param_t>(module, "param_t");
 param_t.def(nb::init<>());
 param_t.def_rw("samples", &soil::param_t::samples);
 param_t.def_rw("maxage", &soil::param_t::maxage);
+param_t.def_rw("seed", &soil::param_t::seed);
 param_t.def_rw("timeStep", &soil::param_t::timeStep);
 param_t.def_rw("critSlope", &soil::param_t::critSlope);
 param_t.def_rw("settleRate", &soil::param_t::settleRate);
@@ -214,6 +355,10 @@ module.def("flow", [](const soil::buffer& buffer, const soil::index& index){
   return soil::flow(buffer, index);
 });
 
+module.def("condition", [](const soil::buffer& buffer, const soil::index& index, const double epsilon){
+  return soil::condition(buffer, index, epsilon);
+}, nb::arg("buffer"), nb::arg("index"), nb::arg("epsilon") = 0.0);
+
 module.def("direction", [](const soil::buffer& buffer, const soil::index& index){
   return soil::direction(buffer, index);
 });
@@ -242,6 +387,60 @@ module.def("distance", [](const soil::buffer& buffer, const soil::index& index,
   return soil::distance(buffer, index, target);
 });
 
+//
+// Flow Graph Type
+//
+
+auto flow_graph = nb::class_<soil::flow_graph>(module, "flow_graph");
+flow_graph.def(nb::init<const soil::buffer&, const soil::index&>());
+flow_graph.def_prop_ro("index", [](const soil::flow_graph& graph){
+  return soil::index(graph.index.ext());
+});
+flow_graph.def_prop_ro("next", [](const soil::flow_graph& graph){
+  return soil::buffer(graph.next);
+});
+flow_graph.def_prop_ro("offset", [](const soil::flow_graph& graph){
+  return soil::buffer(graph.offset);
+});
+flow_graph.def_prop_ro("donors", [](const soil::flow_graph& graph){
+  return soil::buffer(graph.donors);
+});
+flow_graph.def_prop_ro("order", [](const soil::flow_graph& graph){
+  return soil::buffer(graph.order);
+});
+
+module.def("accumulation", [](const soil::flow_graph& graph, int iterations, int samples){
+  return soil::accumulation(graph, iterations, samples);
+});
+
+module.def("accumulation_weighted", [](const soil::flow_graph& graph, const soil::buffer& weights, int iterations, int samples, bool reservoir){
+  return soil::accumulation(graph, weights, iterations, samples, reservoir);
+});
+
+module.def("accumulation_exhaustive", [](const soil::flow_graph& graph){
+  return soil::accumulation_exhaustive(graph);
+});
+
+module.def("accumulation_exhaustive_weighted", [](const soil::flow_graph& graph, const soil::buffer& weights){
+  return soil::accumulation_exhaustive(graph, weights);
+});
+
+module.def("upstream", [](const soil::flow_graph& graph, const glm::ivec2 target){
+  return soil::upstream(graph, target);
+});
+
+module.def("distance", [](const soil::flow_graph& graph, const glm::ivec2 target){
+  return soil::distance(graph, target);
+});
+
+module.def("catchments", [](const soil::flow_graph& graph, const std::vector<glm::ivec2>& targets){
+  return soil::catchments(graph, targets);
+});
+
+module.def("catchments", [](const soil::buffer& buffer, const soil::index& index, const std::vector<glm::ivec2>& targets){
+  return soil::catchments(buffer, index, targets);
+});
+
 }
 
 #endif
\ No newline at end of file
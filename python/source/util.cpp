@@ -18,8 +18,11 @@ namespace nb = nanobind;
 #include <soillib/util/error.hpp>
 
 #include <soillib/op/math.hpp>
+#include <soillib/op/normal.hpp>
+#include <soillib/util/yield.hpp>
 
 #include "glm.hpp"
+#include "half.hpp"
 
 //
 //
@@ -38,6 +41,124 @@ yield.def("__iter__", [](soil::yield<T>& iter){
 
 }
 
+template<typename R>
+void bind_range_t(nb::module_& module, const char* name){
+
+auto range = nb::class_<R>(module, name);
+
+range.def("__iter__", [](R& iter){
+  return nb::make_iterator(nb::type<R>(), "iterator",
+    iter.begin(), iter.end());
+}, nb::keep_alive<0, 1>());
+
+range.def("__len__", [](R& iter){
+  return iter.size();
+});
+
+}
+
+//
+// Yield Reference Iterators
+//  These are the coroutine generators which buffer_t and flat_t
+//  iterated through before they returned a random-access range.
+//  They are kept for the reference loops in soil.reference,
+//  which test/bench_iter.py measures the range loops against.
+//
+
+template<typename T>
+soil::yield<size_t, T> yield_const_iter(const soil::buffer_t<T> buffer) {
+  for (size_t i = 0; i < buffer.elem(); ++i)
+    co_yield soil::make_yield(i, buffer[i]);
+  co_return;
+}
+
+template<typename T>
+soil::yield<size_t, T*> yield_iter(soil::buffer_t<T> buffer) {
+  for (size_t i = 0; i < buffer.elem(); ++i)
+    co_yield soil::make_yield(i, buffer.data() + i);
+  co_return;
+}
+
+template<size_t D>
+soil::yield<typename soil::flat_t<D>::vec_t> yield_positions(const soil::flat_t<D> index) {
+  for (size_t i = 0; i < index.elem(); ++i)
+    co_yield index.unflatten(i);
+  co_return;
+}
+
+//! Reference Operations: the host loops of min, max, cast,
+//! resample and normal, iterating through a yield generator.
+void bind_reference(nb::module_& module){
+
+module.def("min", [](const soil::buffer& buf){
+  return soil::select(buf.type(), [&buf]<std::floating_point S>() -> nb::object {
+    S val = std::numeric_limits<S>::max();
+    for (auto [i, b] : yield_const_iter<S>(buf.as<S>()))
+      if (!std::isnan(b))
+        val = std::min(val, b);
+    return nb::cast(val);
+  });
+});
+
+module.def("max", [](const soil::buffer& buf){
+  return soil::select(buf.type(), [&buf]<std::floating_point S>() -> nb::object {
+    S val = std::numeric_limits<S>::lowest();
+    for (auto [i, b] : yield_const_iter<S>(buf.as<S>()))
+      if (!std::isnan(b))
+        val = std::max(val, b);
+    return nb::cast(val);
+  });
+});
+
+module.def("cast", [](const soil::buffer& buf, const soil::dtype type){
+  return soil::select(type, [&buf]<soil::scalar To>() -> soil::buffer {
+    return soil::select(buf.type(), [&buf]<soil::scalar From>() -> soil::buffer {
+      soil::buffer_t<To> buffer_to(buf.elem());
+      for (auto [i, b] : yield_const_iter<From>(buf.as<From>()))
+        buffer_to[i] = (To)b;
+      return soil::buffer(std::move(buffer_to));
+    });
+  });
+});
+
+module.def("resample", [](const soil::buffer& buffer, const soil::index& index){
+  if (index.type() != soil::dindex::FLAT2)
+    throw std::invalid_argument("reference resample is only implemented for flat 2D indices");
+  return soil::select(buffer.type(), [&]<soil::scalar S>() -> soil::buffer {
+    auto input = buffer.as<S>();
+    auto index_t = index.as<soil::flat_t<2>>();
+    soil::buffer_t<S> output(index_t.elem());
+    for (const auto &pos : yield_positions<2>(index_t))
+      output[index_t.flatten(pos)] = input[index_t.flatten(pos)];
+    return soil::buffer(std::move(output));
+  });
+});
+
+module.def("normal", [](const soil::buffer& buffer, const soil::index& index, const soil::vec3 scale){
+  if (index.type() != soil::dindex::FLAT2)
+    throw std::invalid_argument("reference normal is only implemented for flat 2D indices");
+  return soil::select(buffer.type(), [&]<std::floating_point S>() -> soil::buffer {
+    auto index_t = index.as<soil::flat_t<2>>();
+    auto buffer_t = buffer.as<S>();
+    soil::buffer_t<soil::vec3> output(buffer.elem());
+    for (auto [i, b] : yield_iter<soil::vec3>(output)) {
+      soil::ivec2 position = index_t.unflatten(i);
+      *b = soil::normal::operator()(buffer_t, index_t, position, scale);
+    }
+    return soil::buffer(std::move(output));
+  });
+});
+
+module.def("iter", [](const soil::index& index) -> nb::object {
+  return soil::select(index.type(), [&]<typename T>() -> nb::object
+    requires std::same_as<T, soil::flat_t<T::n_dims>>
+  {
+    return nb::cast(yield_positions<T::n_dims>(index.as<T>()));
+  });
+});
+
+}
+
 //
 //
 //
@@ -55,6 +176,10 @@ nb::enum_<soil::dtype>(module, "dtype")
   .value("float64", soil::dtype::FLOAT64)
   .value("vec2", soil::dtype::VEC2)
   .value("vec3", soil::dtype::VEC3)
+  .value("uint8", soil::dtype::UINT8)
+  .value("int16", soil::dtype::INT16)
+  .value("uint16", soil::dtype::UINT16)
+  .value("float16", soil::dtype::FLOAT16)
   .export_values();
 
 //
@@ -98,6 +223,24 @@ bind_yield_t<soil::flat_t<2>::vec_t>(module, "yield_shape_t_arr_2");
 bind_yield_t<soil::flat_t<3>::vec_t>(module, "yield_shape_t_arr_3");
 bind_yield_t<soil::flat_t<4>::vec_t>(module, "yield_shape_t_arr_4");
 
+//
+// Range Type Binding
+//
+
+bind_range_t<decltype(soil::flat_t<1>().iter())>(module, "range_flat_t_1");
+bind_range_t<decltype(soil::flat_t<2>().iter())>(module, "range_flat_t_2");
+bind_range_t<decltype(soil::flat_t<3>().iter())>(module, "range_flat_t_3");
+bind_range_t<decltype(soil::flat_t<4>().iter())>(module, "range_flat_t_4");
+bind_range_t<decltype(std::declval<const soil::quad&>().iter())>(module, "range_quad");
+bind_range_t<decltype(soil::tiled_t<2>().iter())>(module, "range_tiled_t_2");
+
+//
+// Reference Operations
+//
+
+auto reference = module.def_submodule("reference", "yield (coroutine) reference loops of the host operations");
+bind_reference(reference);
+
 }
 
 #endif
\ No newline at end of file
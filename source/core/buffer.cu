@@ -5,8 +5,8 @@
 
 namespace soil {
 
-size_t buffer_track::mem_cpu = 0;
-size_t buffer_track::mem_gpu = 0;
+buffer_track::counter_t buffer_track::mem_cpu;
+buffer_track::counter_t buffer_track::mem_gpu;
 
 } // end of namespace soil
 
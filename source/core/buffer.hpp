@@ -5,20 +5,230 @@
 //! \todo add more detail about this file
 
 #include <cuda_runtime.h>
+#include <soillib/core/pool.hpp>
 #include <soillib/core/types.hpp>
 #include <soillib/soillib.hpp>
 #include <soillib/util/error.hpp>
-#include <soillib/util/yield.hpp>
+#include <soillib/util/range.hpp>
 
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace soil {
 
+//! buffer_track records the allocations of buffers per device,
+//! and optionally per tag, which attributes allocations made in
+//! a scope on the current thread to a named counter. Nested scopes
+//! are joined with a dot, e.g. "flow" and "graph" to "flow.graph".
+//!
+//! Usage:
+//!
+//! {
+//!   soil::buffer_track::scope scope("erode");
+//!   soil::erode(model, param, steps);
+//! }
+//! auto snapshot = soil::buffer_track::snapshot();
+//! snapshot.tags["erode.track"].peak;
+//!
 namespace buffer_track {
-extern size_t mem_cpu; //!< Allocated CPU Memory in Bytes
-extern size_t mem_gpu; //!< Allocated GPU Memory in Bytes
+
+//! Thread-Safe Allocation Counter
+struct counter_t {
+  std::atomic<size_t> current{0}; //!< Allocated Bytes
+  std::atomic<size_t> peak{0};    //!< Peak Allocated Bytes
+  std::atomic<size_t> allocs{0};  //!< Number of Allocations
+  std::atomic<size_t> frees{0};   //!< Number of De-Allocations
+
+  void add(const size_t bytes) {
+    const size_t now = (this->current += bytes);
+    size_t peak = this->peak.load(std::memory_order_relaxed);
+    while (now > peak && !this->peak.compare_exchange_weak(peak, now))
+      ;
+    ++this->allocs;
+  }
+
+  void sub(const size_t bytes) {
+    this->current -= bytes;
+    ++this->frees;
+  }
+};
+
+//! Counter Snapshot
+struct stats_t {
+  size_t current = 0;
+  size_t peak = 0;
+  size_t allocs = 0;
+  size_t frees = 0;
+};
+
+struct snapshot_t {
+  stats_t cpu;
+  stats_t gpu;
+  std::map<std::string, stats_t> tags;
+};
+
+extern counter_t mem_cpu; //!< Allocated CPU Memory
+extern counter_t mem_gpu; //!< Allocated GPU Memory
+
+//! Tag Counters by Name, and their Mutex
+//! Note: Counters are never destroyed, as buffers point to them.
+struct tags_t {
+  std::mutex mutex;
+  std::map<std::string, counter_t> count;
+};
+
+inline tags_t &tags() {
+  static tags_t *tags = new tags_t();
+  return *tags;
+}
+
+//! Scope Stack of the Current Thread: (Name, Counter)
+inline std::vector<std::pair<std::string, counter_t *>> &stack() {
+  thread_local std::vector<std::pair<std::string, counter_t *>> stack;
+  return stack;
+}
+
+//! Counter of the Innermost Scope of the Current Thread
+inline counter_t *tag() {
+  auto &stack = buffer_track::stack();
+  return stack.empty() ? NULL : stack.back().second;
+}
+
+inline void push(const std::string &name) {
+  auto &stack = buffer_track::stack();
+  const std::string full = stack.empty() ? name : stack.back().first + "." + name;
+  std::lock_guard lock(tags().mutex);
+  stack.emplace_back(full, &tags().count.try_emplace(full).first->second);
+}
+
+inline void pop() {
+  auto &stack = buffer_track::stack();
+  if (!stack.empty())
+    stack.pop_back();
+}
+
+//! RAII Allocation Scope
+struct scope {
+  scope(const std::string &name) { push(name); }
+  ~scope() { pop(); }
+  scope(const scope &) = delete;
+  scope &operator=(const scope &) = delete;
+};
+
+inline stats_t load(const counter_t &counter) {
+  return {counter.current.load(), counter.peak.load(), counter.allocs.load(), counter.frees.load()};
+}
+
+//! Snapshot of all Counters
+inline snapshot_t snapshot() {
+  snapshot_t snapshot{load(mem_cpu), load(mem_gpu), {}};
+  std::lock_guard lock(tags().mutex);
+  for (const auto &[name, counter] : tags().count)
+    snapshot.tags[name] = load(counter);
+  return snapshot;
+}
+
+//! Reset the Counters
+//! Note: Allocated bytes are kept, the peak is reset to them.
+inline void reset() {
+  const auto reset = [](counter_t &counter) {
+    counter.peak = counter.current.load();
+    counter.allocs = 0;
+    counter.frees = 0;
+  };
+  reset(mem_cpu);
+  reset(mem_gpu);
+  std::lock_guard lock(tags().mutex);
+  for (auto &[name, counter] : tags().count)
+    reset(counter);
+}
+
 } // namespace buffer_track
 
+//! Access Pattern Hint for File-Backed Buffers
+enum advice_t {
+  NORMAL,     //!< Default Read-Ahead
+  SEQUENTIAL, //!< Aggressive Read-Ahead, Early Page Release
+  RANDOM      //!< No Read-Ahead
+};
+
+//! buffer_map is the allocation policy of buffers, which routes the
+//! CPU allocations of buffers made in a scope on the current thread to
+//! file-backed memory (see buffer_t<T>::mapped), e.g. for intermediate
+//! buffers which exceed the physical memory. Every buffer is mapped to
+//! its own unlinked temporary file, in the directory of the innermost
+//! scope ($TMPDIR if empty), which is released with the buffer.
+//!
+//! Usage:
+//!
+//! {
+//!   soil::buffer_map::scope scope("/scratch", soil::SEQUENTIAL);
+//!   soil::buffer height(soil::FLOAT32, size_t(1) << 34);
+//! }
+//!
+namespace buffer_map {
+
+struct policy_t {
+  std::string directory; //!< Directory of the Temporary Files
+  advice_t advice;       //!< Access Pattern Hint
+};
+
+//! Policy Stack of the Current Thread
+inline std::vector<policy_t> &stack() {
+  thread_local std::vector<policy_t> stack;
+  return stack;
+}
+
+//! Policy of the Innermost Scope of the Current Thread
+inline const policy_t *policy() {
+  auto &stack = buffer_map::stack();
+  return stack.empty() ? NULL : &stack.back();
+}
+
+inline void push(const std::string &directory, const advice_t advice = NORMAL) {
+  buffer_map::stack().push_back({directory, advice});
+}
+
+inline void pop() {
+  auto &stack = buffer_map::stack();
+  if (!stack.empty())
+    stack.pop_back();
+}
+
+//! RAII Allocation Policy Scope
+struct scope {
+  scope(const std::string &directory = "", const advice_t advice = NORMAL) { push(directory, advice); }
+  ~scope() { pop(); }
+  scope(const scope &) = delete;
+  scope &operator=(const scope &) = delete;
+};
+
+//! Create an Unlinked Temporary File in a Directory ($TMPDIR if empty)
+inline int temporary(const std::string &directory) {
+  const char *dir = std::getenv("TMPDIR");
+  std::string path = !directory.empty() ? directory : (dir != NULL) ? dir : "/tmp";
+  path += "/soillib-XXXXXX";
+  const int fd = mkstemp(path.data());
+  if (fd < 0)
+    throw std::runtime_error("failed to create buffer file " + path);
+  unlink(path.c_str()); // Note: Released when Unmapped
+  return fd;
+}
+
+} // namespace buffer_map
+
 //! \todo Make sure that buffers are "re-interpretable"!
 
 //! buffer_t<T> is a strict-typed, raw-data extent.
@@ -28,7 +238,8 @@ extern size_t mem_gpu; //!< Allocated GPU Memory in Bytes
 //! the raw underlying memory. This is for efficiency.
 //!
 //! buffer_t<T> data can be on the CPU or on the GPU.
-//! convenience iterators are also provided.
+//! convenience iterators are also provided. CPU memory
+//! is recycled through the host_pool allocator.
 //!
 template<typename T>
 struct buffer_t: typedbase {
@@ -46,10 +257,39 @@ struct buffer_t: typedbase {
     this->allocate(size, host);
   }
 
+  //! Wrap External Host Memory (e.g. a File Mapping), which
+  //! is not copied, and is released together with the owner
+  //! when the last reference to the buffer is destroyed.
+  //! Read-only memory (e.g. a PROT_READ mapping) is flagged,
+  //! so that it is not exported as writable.
+  buffer_t(T *data, const size_t size, std::shared_ptr<void> owner, const bool readonly = false) {
+    this->_data = data;
+    this->_size = size;
+    this->_host = CPU;
+    this->_refs = new size_t(1);
+    this->_owner = std::move(owner);
+    this->_readonly = readonly;
+  }
+
   ~buffer_t() override {
     this->deallocate();
   }
 
+  //! File-Backed CPU Buffer
+  //!
+  //! The memory of the buffer is a shared mapping of a file,
+  //! which is created (or grown) to fit the buffer, so that
+  //! the buffer can exceed the physical memory and is paged
+  //! by the operating system. Without a filename, an unlinked
+  //! temporary file in $TMPDIR is used, which is released with
+  //! the buffer. An existing file is never truncated, so that
+  //! its contents are kept and the buffer maps its beginning.
+  //!
+  //! The buffer is a regular CPU buffer and is not counted in
+  //! buffer_track, as its memory is not resident. CPU buffers
+  //! allocated in a buffer_map::scope are mapped in the same way.
+  static buffer_t<T> mapped(const size_t size, const char *filename = NULL, const advice_t advice = NORMAL);
+
   // Copy Semantics
 
   buffer_t(const buffer_t<T> &other) {
@@ -57,6 +297,9 @@ struct buffer_t: typedbase {
     this->_refs = other._refs;
     this->_size = other._size;
     this->_host = other._host;
+    this->_owner = other._owner;
+    this->_tag = other._tag;
+    this->_readonly = other._readonly;
     if (this->_data != NULL) {
       ++(*this->_refs);
     }
@@ -68,6 +311,9 @@ struct buffer_t: typedbase {
     this->_refs = other._refs;
     this->_size = other._size;
     this->_host = other._host;
+    this->_owner = other._owner;
+    this->_tag = other._tag;
+    this->_readonly = other._readonly;
     if (this->_data != NULL) {
       ++(*this->_refs);
     }
@@ -81,6 +327,9 @@ struct buffer_t: typedbase {
     this->_refs = other._refs;
     this->_size = other._size;
     this->_host = other._host;
+    this->_owner = std::move(other._owner);
+    this->_tag = other._tag;
+    this->_readonly = other._readonly;
     other._data = NULL;
     other._refs = NULL;
     other._size = 0;
@@ -92,6 +341,9 @@ struct buffer_t: typedbase {
     this->_refs = other._refs;
     this->_size = other._size;
     this->_host = other._host;
+    this->_owner = std::move(other._owner);
+    this->_tag = other._tag;
+    this->_readonly = other._readonly;
     other._data = NULL;
     other._refs = NULL;
     other._size = 0;
@@ -113,6 +365,7 @@ struct buffer_t: typedbase {
 
   GPU_ENABLE inline size_t refs() const { return *this->_refs; } //!< Internal Reference Count
   GPU_ENABLE inline host_t host() const { return this->_host; }  //!< Current Device (CPU / GPU)
+  inline bool readonly() const { return this->_readonly; }       //!< Memory is Read-Only
 
   //! Const Subscript Operator
   GPU_ENABLE T operator[](const size_t index) const noexcept {
@@ -126,17 +379,25 @@ struct buffer_t: typedbase {
 
   // Iterators
 
+  //! Range Functors: (Index, Value) and (Index, Pointer) Pairs
+  struct const_item_t {
+    const T *data;
+    std::tuple<size_t, T> operator()(const size_t i) const { return {i, data[i]}; }
+  };
+
+  struct item_t {
+    T *data;
+    std::tuple<size_t, T *> operator()(const size_t i) const { return {i, data + i}; }
+  };
+
   //! Simple Const / Non-Const Iterators
-  yield<size_t, T> const_iter() const {
-    for (size_t i = 0; i < this->elem(); ++i)
-      co_yield make_yield(i, this->operator[](i));
-    co_return;
+  //! Note: These reference the data and should not outlive the buffer.
+  range_t<const_item_t> const_iter() const {
+    return range_t<const_item_t>({this->data()}, this->elem());
   }
 
-  yield<size_t, T *> iter() {
-    for (size_t i = 0; i < this->elem(); ++i)
-      co_yield make_yield(i, &this->operator[](i));
-    co_return;
+  range_t<item_t> iter() {
+    return range_t<item_t>({this->data()}, this->elem());
   }
 
 private:
@@ -144,10 +405,17 @@ private:
   void allocate(const size_t size, const host_t host = CPU);
   void deallocate();
 
+  //! Map an Open File (which is closed) into a File-Backed Buffer
+  static buffer_t<T> map(const size_t size, const int fd, const advice_t advice);
+
   T *_data = NULL;      //!< Raw Data Pointer (Device Agnostic)
   size_t _size = 0;     //!< Number of Data Elements
   host_t _host = CPU;   //!< Currently Active Device
   size_t *_refs = NULL; //!< Pointer to Reference Count
+
+  std::shared_ptr<void> _owner;         //!< Owner of External Memory (Optional)
+  buffer_track::counter_t *_tag = NULL; //!< Allocation Tag Counter (Optional)
+  bool _readonly = false;               //!< Read-Only External Memory
 };
 
 template<typename T>
@@ -156,21 +424,32 @@ void soil::buffer_t<T>::allocate(const size_t size, const host_t host) {
   if (size == 0)
     throw std::invalid_argument("size must be greater than 0");
 
+  if (host == CPU && buffer_map::policy() != NULL) {
+    const buffer_map::policy_t policy = *buffer_map::policy();
+    *this = buffer_t<T>::map(size, buffer_map::temporary(policy.directory), policy.advice);
+    return;
+  }
+
   this->_size = size;
 
   if (host == CPU) {
-    this->_data = new T[size];
-    buffer_track::mem_cpu += this->size();
+    this->_data = (T *)host_pool::get().allocate(this->size());
+    std::uninitialized_default_construct_n(this->_data, size);
+    buffer_track::mem_cpu.add(this->size());
   }
 
   else if (host == GPU) {
     cudaMalloc(&this->_data, this->size());
-    buffer_track::mem_gpu += this->size();
+    buffer_track::mem_gpu.add(this->size());
   }
 
   else
     throw std::invalid_argument("device not recognized");
 
+  this->_tag = buffer_track::tag();
+  if (this->_tag != NULL)
+    this->_tag->add(this->size());
+
   this->_host = host;
   this->_refs = new size_t(1);
 }
@@ -185,15 +464,29 @@ void soil::buffer_t<T>::deallocate() {
     return;
 
   (*this->_refs)--;
-  if (*this->_refs > 0)
+  if (*this->_refs > 0) {
+    this->_owner = NULL;
     return;
+  }
 
   delete this->_refs;
 
+  if (this->_owner != NULL) {
+    this->_owner = NULL;
+    this->_data = NULL;
+    this->_size = 0;
+    this->_host = CPU;
+    return;
+  }
+
+  if (this->_data != NULL && this->_tag != NULL)
+    this->_tag->sub(this->size());
+
   if (this->_data != NULL) {
     if (this->_host == CPU) {
-      delete[] this->_data;
-      buffer_track::mem_cpu -= this->size();
+      std::destroy_n(this->_data, this->_size);
+      host_pool::get().deallocate(this->_data, this->size());
+      buffer_track::mem_cpu.sub(this->size());
       this->_data = NULL;
       this->_size = 0;
       this->_host = CPU;
@@ -202,7 +495,7 @@ void soil::buffer_t<T>::deallocate() {
     if (this->_host == GPU) {
 
       cudaFree(this->_data);
-      buffer_track::mem_gpu -= this->size();
+      buffer_track::mem_gpu.sub(this->size());
       this->_data = NULL;
       this->_size = 0;
       this->_host = CPU;
@@ -210,6 +503,56 @@ void soil::buffer_t<T>::deallocate() {
   }
 }
 
+template<typename T>
+soil::buffer_t<T> soil::buffer_t<T>::mapped(const size_t size, const char *filename, const advice_t advice) {
+
+  if (size == 0)
+    throw std::invalid_argument("size must be greater than 0");
+
+  int fd = -1;
+  if (filename != NULL && filename[0] != '\0') {
+    fd = ::open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+      throw std::runtime_error("failed to create buffer file " + std::string(filename));
+  } else {
+    fd = buffer_map::temporary("");
+  }
+
+  return buffer_t<T>::map(size, fd, advice);
+}
+
+template<typename T>
+soil::buffer_t<T> soil::buffer_t<T>::map(const size_t size, const int fd, const advice_t advice) {
+
+  const size_t length = size * sizeof(T);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("failed to stat buffer file");
+  }
+  if (size_t(st.st_size) < length && ftruncate(fd, length) != 0) {
+    ::close(fd);
+    throw std::runtime_error("failed to resize buffer file");
+  }
+
+  void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd); // Note: The Mapping keeps the File Open
+
+  if (base == MAP_FAILED)
+    throw std::runtime_error("failed to map buffer file");
+
+  if (advice == SEQUENTIAL)
+    madvise(base, length, MADV_SEQUENTIAL);
+  else if (advice == RANDOM)
+    madvise(base, length, MADV_RANDOM);
+
+  std::shared_ptr<void> mapping(base, [length](void *base) {
+    munmap(base, length);
+  });
+
+  return buffer_t<T>((T *)base, size, std::move(mapping));
+}
+
 template<typename T>
 void soil::buffer_t<T>::to_gpu() {
 
@@ -228,14 +571,20 @@ void soil::buffer_t<T>::to_gpu() {
   cudaMalloc(&_data, this->size());
   cudaMemcpy(_data, this->data(), this->size(), cudaMemcpyHostToDevice);
 
-  buffer_track::mem_gpu += this->size();
-  //  buffer_track::mem_cpu -= this->size();
-
+  // Note: The host memory is only released (and counted)
+  //  when this was the last reference to it.
+  buffer_track::counter_t *tag = this->_tag;
   this->deallocate();
   this->_data = _data;
   this->_refs = new size_t(1);
   this->_size = _size;
   this->_host = GPU;
+  this->_tag = tag;
+  this->_readonly = false;
+
+  buffer_track::mem_gpu.add(this->size());
+  if (tag != NULL)
+    tag->add(this->size());
 }
 
 template<typename T>
@@ -251,17 +600,23 @@ void soil::buffer_t<T>::to_cpu() {
     return;
 
   size_t _size = this->_size;
-  T *_data = new T[_size];
+  T *_data = (T *)host_pool::get().allocate(this->size());
+  std::uninitialized_default_construct_n(_data, _size);
   cudaMemcpy(_data, this->data(), this->size(), cudaMemcpyDeviceToHost);
 
-  buffer_track::mem_cpu += this->size();
-  //  buffer_track::mem_gpu -= this->size();
-
+  // Note: The device memory is only released (and counted)
+  //  when this was the last reference to it.
+  buffer_track::counter_t *tag = this->_tag;
   this->deallocate();
   this->_data = _data;
   this->_refs = new size_t(1);
   this->_size = _size;
   this->_host = CPU;
+  this->_tag = tag;
+
+  buffer_track::mem_cpu.add(this->size());
+  if (tag != NULL)
+    tag->add(this->size());
 }
 
 //! buffer is a poylymorphic buffer_t wrapper type.
@@ -279,6 +634,13 @@ struct buffer {
 
   buffer(const soil::dtype type, const size_t size, const host_t host): impl{make(type, size, host)} {}
 
+  //! File-Backed Buffer (see buffer_t<T>::mapped)
+  static buffer mapped(const soil::dtype type, const size_t size, const char *filename = NULL, const advice_t advice = NORMAL) {
+    return select(type, [&]<typename S>() -> buffer {
+      return soil::buffer_t<S>::mapped(size, filename, advice);
+    });
+  }
+
   //! Note that since it holds a shared pointer to a buffer_t,
   //! holding a shared pointer, if the copied or moved object
   //! is destroyed, the underlying raw memory is not deleted.
@@ -364,6 +726,12 @@ struct buffer {
     });
   }
 
+  bool readonly() const {
+    return select(this->type(), [self = this]<typename S>() {
+      return self->as<S>().readonly();
+    });
+  }
+
 private:
   using ptr_t = std::shared_ptr<typedbase>;
   ptr_t impl; //!< Strict-Typed Implementation Base Pointer
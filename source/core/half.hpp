@@ -0,0 +1,146 @@
+#ifndef SOILLIB_HALF
+#define SOILLIB_HALF
+
+#include <soillib/soillib.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace soil {
+
+//! half is an IEEE 754 binary16 storage type, which is converted
+//! to and from float for all arithmetic. It is layout-compatible
+//! with numpy.float16 and with 16-bit floating-point TIFF samples.
+//!
+//! Note: std::float16_t is not available in the CUDA translation
+//!  units (C++20), which share the buffer type dispatch with the
+//!  host, so the conversion is implemented here for both.
+//!
+struct half {
+
+  half() = default;
+  GPU_ENABLE half(const float value): bits{half::encode(value)} {}
+  GPU_ENABLE operator float() const { return half::decode(this->bits); }
+
+  //! Half from Raw Bits
+  GPU_ENABLE static constexpr half raw(const uint16_t bits) {
+    half h{};
+    h.bits = bits;
+    return h;
+  }
+
+  // Compound Assignment (in Single Precision)
+
+  GPU_ENABLE half &operator+=(const float rhs) { return *this = float(*this) + rhs; }
+  GPU_ENABLE half &operator-=(const float rhs) { return *this = float(*this) - rhs; }
+  GPU_ENABLE half &operator*=(const float rhs) { return *this = float(*this) * rhs; }
+  GPU_ENABLE half &operator/=(const float rhs) { return *this = float(*this) / rhs; }
+
+  uint16_t bits; //!< Sign, 5-Bit Exponent, 10-Bit Mantissa
+
+  //! Float to Half, Rounded to Nearest Even
+  GPU_ENABLE static uint16_t encode(const float value) {
+
+    const uint32_t x = half::as_uint(value);
+    const uint32_t sign = (x >> 16) & 0x8000;
+    const uint32_t abs = x & 0x7FFFFFFF;
+
+    if (abs >= 0x7F800000) // Infinity and NaN (Quiet)
+      return sign | 0x7C00 | ((abs > 0x7F800000) ? 0x0200 : 0);
+
+    if (abs >= 0x477FF000) // Overflow: Rounds to Infinity
+      return sign | 0x7C00;
+
+    if (abs < 0x38800000) { // Subnormal or Zero
+      if (abs <= 0x33000000)
+        return sign;
+      const uint32_t shift = 126 - (abs >> 23);
+      const uint32_t m = (abs & 0x7FFFFF) | 0x800000;
+      uint32_t h = m >> shift;
+      const uint32_t rem = m & ((1u << shift) - 1);
+      const uint32_t mid = 1u << (shift - 1);
+      if (rem > mid || (rem == mid && (h & 1)))
+        ++h;
+      return sign | h;
+    }
+
+    // Normal: Re-Bias the Exponent (127 to 15)
+    uint32_t h = (abs - 0x38000000) >> 13;
+    const uint32_t rem = abs & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+      ++h; // Note: Carries into the Exponent
+    return sign | h;
+  }
+
+  //! Half to Float (Exact)
+  GPU_ENABLE static float decode(const uint16_t bits) {
+
+    const uint32_t sign = uint32_t(bits & 0x8000) << 16;
+    const uint32_t exp = (bits >> 10) & 0x1F;
+    const uint32_t man = bits & 0x3FF;
+
+    if (exp == 0x1F)
+      return half::as_float(sign | 0x7F800000 | (man << 13));
+
+    if (exp == 0) { // Subnormal: man * 2^-24
+      const float value = float(man) * 5.9604644775390625E-8f;
+      return sign ? -value : value;
+    }
+
+    return half::as_float(sign | ((exp + 112) << 23) | (man << 13));
+  }
+
+private:
+  GPU_ENABLE static uint32_t as_uint(const float value) {
+#ifdef __CUDA_ARCH__
+    return __float_as_uint(value);
+#else
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    return bits;
+#endif
+  }
+
+  GPU_ENABLE static float as_float(const uint32_t bits) {
+#ifdef __CUDA_ARCH__
+    return __uint_as_float(bits);
+#else
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+#endif
+  }
+};
+
+} // end of namespace soil
+
+//! Numeric Limits of the Half-Precision Storage Type
+template<>
+struct std::numeric_limits<soil::half> {
+  static constexpr bool is_specialized = true;
+  static constexpr bool is_signed = true;
+  static constexpr bool is_integer = false;
+  static constexpr bool is_exact = false;
+  static constexpr bool has_infinity = true;
+  static constexpr bool has_quiet_NaN = true;
+  static constexpr bool has_signaling_NaN = true;
+  static constexpr bool is_iec559 = true;
+  static constexpr bool is_bounded = true;
+  static constexpr int digits = 11;
+  static constexpr int digits10 = 3;
+  static constexpr int radix = 2;
+  static constexpr int min_exponent = -13;
+  static constexpr int max_exponent = 16;
+
+  static constexpr soil::half min() noexcept { return soil::half::raw(0x0400); }
+  static constexpr soil::half max() noexcept { return soil::half::raw(0x7BFF); }
+  static constexpr soil::half lowest() noexcept { return soil::half::raw(0xFBFF); }
+  static constexpr soil::half epsilon() noexcept { return soil::half::raw(0x1400); }
+  static constexpr soil::half infinity() noexcept { return soil::half::raw(0x7C00); }
+  static constexpr soil::half quiet_NaN() noexcept { return soil::half::raw(0x7E00); }
+  static constexpr soil::half signaling_NaN() noexcept { return soil::half::raw(0x7D00); }
+  static constexpr soil::half denorm_min() noexcept { return soil::half::raw(0x0001); }
+};
+
+#endif
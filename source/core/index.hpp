@@ -3,7 +3,9 @@
 
 #include <iostream>
 #include <soillib/index/flat.hpp>
+#include <soillib/index/morton.hpp>
 #include <soillib/index/quad.hpp>
+#include <soillib/index/tiled.hpp>
 
 //! index is a polymorphic index_t wrapper
 //!
@@ -51,6 +53,18 @@ auto select(const soil::dindex type, F lambda, Args &&...args) {
     } else {
       throw std::invalid_argument("index type not supported for this operation");
     }
+  case soil::dindex::MORTON:
+    if constexpr (matches_lambda<soil::morton_t, F, Args...>) {
+      return lambda.template operator()<soil::morton_t>(std::forward<Args>(args)...);
+    } else {
+      throw std::invalid_argument("index type not supported for this operation");
+    }
+  case soil::dindex::TILED2:
+    if constexpr (matches_lambda<soil::tiled_t<2>, F, Args...>) {
+      return lambda.template operator()<soil::tiled_t<2>>(std::forward<Args>(args)...);
+    } else {
+      throw std::invalid_argument("index type not supported for this operation");
+    }
   default:
     throw std::invalid_argument("index not supported");
   }
@@ -71,6 +85,10 @@ struct index {
   index(const vec_t<3> vec) { this->impl = std::make_shared<flat_t<3>>(vec); }
   index(const vec_t<4> vec) { this->impl = std::make_shared<flat_t<4>>(vec); }
 
+  //! Construct from a Strict-Typed Index (e.g. morton_t, tiled_t)
+  template<std::derived_from<indexbase> T>
+  index(const T &index) { this->impl = std::make_shared<T>(index); }
+
   index(const std::vector<std::tuple<vec_t<2>, vec_t<2>>> &data) {
     std::vector<quad_node> nodes;
     for (auto &[min, max] : data)
@@ -0,0 +1,207 @@
+#ifndef SOILLIB_POOL
+#define SOILLIB_POOL
+
+#include <soillib/util/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace soil {
+
+//! host_pool is a size-class caching allocator for host memory,
+//! which recycles the memory of freed buffers for later buffers
+//! of similar size, instead of returning it to the OS.
+//!
+//! Requests are rounded up to one of four size classes per power
+//! of two (i.e. at most 25% overhead). Every class caches a fixed
+//! number of free blocks in atomic slots, which are claimed and
+//! filled without locks. Blocks are 64-byte aligned, and blocks
+//! of at least 16 MB are huge-page aligned and marked as such.
+//! Their class sizes are multiples of 2 MB, so that huge pages
+//! don't add to the class overhead.
+//!
+//! The cached bytes are bounded by the limit, which defaults to
+//! 2 GB and can be set with the SOILLIB_POOL_LIMIT variable (in
+//! bytes, 0 disables caching). With SOILLIB_FIRST_TOUCH=1, new
+//! blocks are first touched by the host thread pool, placing
+//! their pages on the NUMA nodes of the threads that use them.
+//!
+struct host_pool {
+
+  static constexpr size_t align = 64;       //!< Minimum Block Alignment
+  static constexpr size_t huge = 1 << 21;   //!< Huge-Page Alignment
+  static constexpr size_t huge_min = 1 << 24; //!< Minimum Huge-Page Block
+  static constexpr size_t depth = 8;        //!< Cached Blocks per Class
+  static constexpr size_t n_classes = 169;  //!< Size Classes (64 B - 256 TB)
+
+  //! Pool Statistics
+  struct stats_t {
+    size_t hits = 0;   //!< Allocations Served from the Pool
+    size_t misses = 0; //!< Allocations Served by the OS
+    size_t cached = 0; //!< Cached Bytes
+    size_t blocks = 0; //!< Cached Blocks
+  };
+
+  //! Global Host Memory Pool
+  //! Note: The pool is never destroyed, so that buffers
+  //! can be released during static destruction.
+  static host_pool &get() {
+    static host_pool *pool = new host_pool();
+    return *pool;
+  }
+
+  void *allocate(const size_t bytes);
+  void deallocate(void *data, const size_t bytes);
+  void release(); //!< Return all Cached Blocks to the OS
+
+  stats_t stats() const {
+    return {this->hits.load(), this->misses.load(), this->cached.load(), this->blocks.load()};
+  }
+
+  std::atomic<size_t> limit;       //!< Maximum Cached Bytes
+  std::atomic<bool> first_touch;   //!< Parallel First-Touch of New Blocks
+
+private:
+  host_pool() {
+    const char *env_limit = std::getenv("SOILLIB_POOL_LIMIT");
+    const char *env_touch = std::getenv("SOILLIB_FIRST_TOUCH");
+    this->limit = (env_limit != NULL) ? std::strtoull(env_limit, NULL, 10) : (size_t(1) << 31);
+    this->first_touch = (env_touch != NULL) && std::atoi(env_touch) != 0;
+    for (auto &slots : this->slots)
+      for (auto &slot : slots)
+        slot = NULL;
+  }
+
+  //! Size Class of a Request (n_classes if not Pooled)
+  static size_t index(const size_t bytes) {
+    if (bytes <= 64)
+      return 0;
+    const size_t k = std::bit_width(bytes - 1) - 1; // 2^k < bytes <= 2^(k+1)
+    const size_t step = size_t(1) << (k - 2);
+    const size_t j = (bytes - (size_t(1) << k) + step - 1) / step - 1;
+    return std::min(n_classes, 1 + 4 * (k - 6) + j);
+  }
+
+  //! Block Size of a Size Class (incl. Alignment)
+  static size_t block(const size_t c) {
+    size_t size = 64;
+    if (c > 0) {
+      const size_t k = 6 + (c - 1) / 4;
+      const size_t j = (c - 1) % 4;
+      size = (size_t(1) << k) + (j + 1) * (size_t(1) << (k - 2));
+    }
+    return (size + align - 1) / align * align;
+  }
+
+  //! Allocate a Block from the OS
+  void *allocate_os(const size_t size) const;
+
+  std::atomic<void *> slots[n_classes][depth];
+  std::atomic<size_t> hits{0};
+  std::atomic<size_t> misses{0};
+  std::atomic<size_t> cached{0};
+  std::atomic<size_t> blocks{0};
+};
+
+// Implementations
+
+inline void *host_pool::allocate_os(const size_t size) const {
+
+  // Note: aligned_alloc requires a multiple of the alignment,
+  //  which pooled blocks of at least huge_min already are.
+  const size_t a = (size >= huge_min) ? huge : align;
+  void *data = std::aligned_alloc(a, (size + a - 1) / a * a);
+  if (data == NULL)
+    throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+  if (a == huge)
+    madvise(data, size, MADV_HUGEPAGE);
+#endif
+
+  // Note: Pages are placed on the NUMA node of the first
+  //  thread which writes to them, so that touching them with
+  //  the thread pool matches the placement to parallel kernels.
+  if (this->first_touch && size >= huge) {
+    soil::parallel_chunk(size, huge, [data](const size_t, const size_t start, const size_t stop) {
+      std::memset((char *)data + start, 0, stop - start);
+    });
+  }
+
+  return data;
+}
+
+inline void *host_pool::allocate(const size_t bytes) {
+
+  const size_t c = host_pool::index(bytes);
+  if (c >= n_classes) {
+    ++this->misses;
+    return this->allocate_os(bytes);
+  }
+
+  const size_t size = host_pool::block(c);
+  for (auto &slot : this->slots[c]) {
+    if (slot.load(std::memory_order_relaxed) == NULL)
+      continue;
+    void *data = slot.exchange(NULL, std::memory_order_acquire);
+    if (data != NULL) {
+      this->cached -= size;
+      --this->blocks;
+      ++this->hits;
+      return data;
+    }
+  }
+
+  ++this->misses;
+  return this->allocate_os(size);
+}
+
+inline void host_pool::deallocate(void *data, const size_t bytes) {
+
+  if (data == NULL)
+    return;
+
+  // Note: The bytes and block are reserved before the block is
+  //  published, so that a concurrent claim can't decrement them
+  //  below zero. The reservation is rolled back on failure.
+  const size_t c = host_pool::index(bytes);
+  if (c < n_classes) {
+    const size_t size = host_pool::block(c);
+    if (this->cached.fetch_add(size) + size <= this->limit.load(std::memory_order_relaxed)) {
+      ++this->blocks;
+      for (auto &slot : this->slots[c]) {
+        void *empty = NULL;
+        if (slot.compare_exchange_strong(empty, data, std::memory_order_release))
+          return;
+      }
+      --this->blocks;
+    }
+    this->cached -= size;
+  }
+
+  std::free(data);
+}
+
+inline void host_pool::release() {
+  for (size_t c = 0; c < n_classes; ++c) {
+    for (auto &slot : this->slots[c]) {
+      void *data = slot.exchange(NULL, std::memory_order_acquire);
+      if (data != NULL) {
+        this->cached -= host_pool::block(c);
+        --this->blocks;
+        std::free(data);
+      }
+    }
+  }
+}
+
+} // end of namespace soil
+
+#endif
@@ -3,8 +3,11 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <soillib/core/half.hpp>
 #include <soillib/soillib.hpp>
 
+#include <concepts>
+#include <cstdint>
 #include <format>
 #include <typeinfo>
 
@@ -29,7 +32,13 @@ enum dtype {
   IVEC4,
   DVEC2,
   DVEC3,
-  DVEC4
+  DVEC4,
+  // Compact Storage Types
+  //  Note: Appended, as the values are stored in .soil archives.
+  UINT8,
+  INT16,
+  UINT16,
+  FLOAT16
 };
 
 // Compute Device Enumerator
@@ -136,6 +145,34 @@ struct typedesc<double> {
   typedef double value_t;
 };
 
+template<>
+struct typedesc<uint8_t> {
+  static constexpr std::string name = "uint8";
+  static constexpr dtype type = UINT8;
+  typedef uint8_t value_t;
+};
+
+template<>
+struct typedesc<int16_t> {
+  static constexpr std::string name = "int16";
+  static constexpr dtype type = INT16;
+  typedef int16_t value_t;
+};
+
+template<>
+struct typedesc<uint16_t> {
+  static constexpr std::string name = "uint16";
+  static constexpr dtype type = UINT16;
+  typedef uint16_t value_t;
+};
+
+template<>
+struct typedesc<half> {
+  static constexpr std::string name = "float16";
+  static constexpr dtype type = FLOAT16;
+  typedef half value_t;
+};
+
 template<>
 struct typedesc<vec2> {
   static constexpr std::string name = "vec2";
@@ -164,6 +201,10 @@ struct typedesc<ivec3> {
   typedef int value_t;
 };
 
+//! Scalar Buffer Types, incl. the Half-Precision Storage Type
+template<typename T>
+concept scalar = std::is_arithmetic_v<T> || std::same_as<T, half>;
+
 // Enum-Based Runtime Polymorphic Visitor Pattern:
 //
 //  Strict-typed, templated implementations of polymorphic
@@ -302,6 +343,34 @@ auto select(const soil::dtype type, F lambda, Args &&...args) {
       throw soil::type_op_error<ivec3, F>(lambda);
     }
     break;
+  case soil::UINT8:
+    if constexpr (matches_lambda<uint8_t, F, Args...>) {
+      return lambda.template operator()<uint8_t>(std::forward<Args>(args)...);
+    } else {
+      throw soil::type_op_error<uint8_t, F>(lambda);
+    }
+    break;
+  case soil::INT16:
+    if constexpr (matches_lambda<int16_t, F, Args...>) {
+      return lambda.template operator()<int16_t>(std::forward<Args>(args)...);
+    } else {
+      throw soil::type_op_error<int16_t, F>(lambda);
+    }
+    break;
+  case soil::UINT16:
+    if constexpr (matches_lambda<uint16_t, F, Args...>) {
+      return lambda.template operator()<uint16_t>(std::forward<Args>(args)...);
+    } else {
+      throw soil::type_op_error<uint16_t, F>(lambda);
+    }
+    break;
+  case soil::FLOAT16:
+    if constexpr (matches_lambda<half, F, Args...>) {
+      return lambda.template operator()<half>(std::forward<Args>(args)...);
+    } else {
+      throw soil::type_op_error<half, F>(lambda);
+    }
+    break;
   default:
     throw std::invalid_argument("type not supported");
   }
@@ -318,7 +387,9 @@ enum dindex {
   FLAT2,
   FLAT3,
   FLAT4,
-  QUAD
+  QUAD,
+  MORTON,
+  TILED2
 };
 
 // base class
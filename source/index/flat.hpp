@@ -3,7 +3,7 @@
 
 #include <soillib/core/types.hpp>
 #include <soillib/soillib.hpp>
-#include <soillib/util/yield.hpp>
+#include <soillib/util/range.hpp>
 
 #include <vector>
 
@@ -14,13 +14,13 @@ namespace {
 template<size_t D>
 GPU_ENABLE size_t prod(const glm::vec<D, int> vec) {
   if constexpr (D == 1) {
-    return vec[0];
+    return size_t(vec[0]);
   } else if constexpr (D == 2) {
-    return vec[0] * vec[1];
+    return size_t(vec[0]) * size_t(vec[1]);
   } else if constexpr (D == 3) {
-    return vec[0] * vec[1] * vec[2];
+    return size_t(vec[0]) * size_t(vec[1]) * size_t(vec[2]);
   } else if constexpr (D == 4) {
-    return vec[0] * vec[1] * vec[2] * vec[3];
+    return size_t(vec[0]) * size_t(vec[1]) * size_t(vec[2]) * size_t(vec[3]);
   } else {
     return 0;
   }
@@ -107,14 +107,12 @@ struct flat_t: indexbase {
     return false;
   }
 
-  //! Position Generator
+  //! Position Range
   //!
-  //! This returns a generator coroutine,
+  //! This returns a random-access range,
   //! which iterates over the set of positions.
-  yield<vec_t> iter() const {
-    for (size_t i = 0; i < this->elem(); ++i)
-      co_yield unflatten(i);
-    co_return;
+  range_t<unflatten_t<flat_t<D>>> iter() const {
+    return range_t<unflatten_t<flat_t<D>>>({*this}, this->elem());
   }
 
 private:
@@ -0,0 +1,147 @@
+#ifndef SOILLIB_INDEX_MORTON
+#define SOILLIB_INDEX_MORTON
+
+#include <soillib/core/types.hpp>
+#include <soillib/soillib.hpp>
+#include <soillib/util/yield.hpp>
+
+#include <soillib/external/libmorton/morton.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace soil {
+
+//! morton_t is a 2-dimensional index with Z-order (Morton) layout
+//!
+//! positions are mapped to flat indices by interleaving the bits
+//! of their coordinates, so that cells which are close in space
+//! are also close in memory, in both dimensions. This makes it a
+//! cache-friendly layout for stencil-heavy (neighborhood) kernels.
+//!
+//! the second coordinate occupies the lower bit of every pair,
+//! matching the fast axis of flat_t<2>. Since the code is monotonic
+//! in each coordinate, the largest index is the code of ext() - 1.
+//! For extents which are not a square power of two, the domain of
+//! indices is therefore padded and elem() exceeds the number of
+//! positions. Padding cells are never returned by iter().
+//!
+//! The padding grows with the aspect ratio of the extent (e.g. about
+//! 550x for 40000 x 100), so extents whose padded size exceeds
+//! max_padding times the number of positions are rejected. Near-square
+//! extents are padded by less than 3x. Use tiled_t for elongated ones.
+//!
+//! On the host, codes are computed by libmorton.
+//!
+struct morton_t: indexbase {
+
+  static constexpr size_t D = 2; //!< Dimensionality
+  static constexpr size_t n_dims = D;
+  typedef glm::vec<D, int> vec_t;
+
+  //! Maximum Ratio of Padded Size to Number of Positions
+  static constexpr size_t max_padding = 4;
+
+  morton_t() = default;
+  morton_t(const vec_t _vec): _vec{_vec} {
+    if (_vec[0] < 0 || _vec[1] < 0)
+      throw std::invalid_argument("extent must not be negative");
+    const size_t cells = size_t(_vec[0]) * size_t(_vec[1]);
+    if (this->elem() > max_padding * cells)
+      throw std::invalid_argument("extent is too elongated for morton layout");
+  }
+
+  static constexpr size_t dims() noexcept {
+    return D;
+  }
+
+  constexpr soil::dindex type() noexcept override {
+    return soil::dindex::MORTON;
+  }
+
+  //! Number of Elements (incl. Padding)
+  GPU_ENABLE inline size_t elem() const {
+    if (this->_vec[0] <= 0 || this->_vec[1] <= 0)
+      return 0;
+    return this->flatten(this->_vec - vec_t(1)) + 1;
+  }
+
+  GPU_ENABLE vec_t min() const noexcept { return vec_t{0}; }
+  GPU_ENABLE vec_t max() const noexcept { return this->_vec; }
+  GPU_ENABLE vec_t ext() const noexcept { return this->_vec; }
+
+  //! Extent Subscript Operator
+  GPU_ENABLE inline size_t operator[](const size_t d) const {
+    return this->_vec[d];
+  }
+
+  // Flattening / Unflattening
+
+  GPU_ENABLE size_t flatten(const vec_t pos) const {
+#ifdef __CUDA_ARCH__
+    return split(pos[1]) | (split(pos[0]) << 1);
+#else
+    return libmorton::morton2D_64_encode(pos[1], pos[0]);
+#endif
+  }
+
+  GPU_ENABLE vec_t unflatten(const size_t index) const {
+#ifdef __CUDA_ARCH__
+    return vec_t(compact(index >> 1), compact(index));
+#else
+    uint_fast32_t x, y;
+    libmorton::morton2D_64_decode(index, y, x);
+    return vec_t(x, y);
+#endif
+  }
+
+  //! Out-Of-Bounds Check (Compact)
+  GPU_ENABLE bool oob(const vec_t pos) const {
+    for (size_t d = 0; d < D; ++d)
+      if (pos[d] < 0 || pos[d] >= this->_vec[d])
+        return true;
+    return false;
+  }
+
+  //! Position Generator
+  //!
+  //! This returns a generator coroutine, which iterates
+  //! over the set of positions in Z-order, skipping padding.
+  yield<vec_t> iter() const {
+    for (size_t i = 0; i < this->elem(); ++i) {
+      const vec_t pos = unflatten(i);
+      if (!this->oob(pos))
+        co_yield pos;
+    }
+    co_return;
+  }
+
+private:
+  //! Spread the Bits of a 32-Bit Coordinate (Magic Bits)
+  GPU_ENABLE static uint64_t split(const uint32_t value) {
+    uint64_t x = value;
+    x = (x | x << 16) & 0x0000FFFF0000FFFF;
+    x = (x | x << 8) & 0x00FF00FF00FF00FF;
+    x = (x | x << 4) & 0x0F0F0F0F0F0F0F0F;
+    x = (x | x << 2) & 0x3333333333333333;
+    x = (x | x << 1) & 0x5555555555555555;
+    return x;
+  }
+
+  //! Gather every Second Bit into a 32-Bit Coordinate
+  GPU_ENABLE static uint32_t compact(const uint64_t value) {
+    uint64_t x = value & 0x5555555555555555;
+    x = (x | x >> 1) & 0x3333333333333333;
+    x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0F;
+    x = (x | x >> 4) & 0x00FF00FF00FF00FF;
+    x = (x | x >> 8) & 0x0000FFFF0000FFFF;
+    x = (x | x >> 16) & 0x00000000FFFFFFFF;
+    return uint32_t(x);
+  }
+
+  vec_t _vec;
+};
+
+} // end of namespace soil
+
+#endif
@@ -4,8 +4,9 @@
 #include <soillib/core/types.hpp>
 #include <soillib/index/flat.hpp>
 #include <soillib/soillib.hpp>
-#include <soillib/util/yield.hpp>
+#include <soillib/util/range.hpp>
 
+#include <algorithm>
 #include <climits>
 #include <vector>
 
@@ -65,6 +66,7 @@ struct quad: indexbase {
       this->_max = glm::max(this->_max, node.max());
     }
     this->_ext = this->_max - this->_min;
+    this->build();
   }
 
   static constexpr size_t dims() noexcept {
@@ -82,40 +84,24 @@ struct quad: indexbase {
   // Flattening / Unflattening Interface
 
   GPU_ENABLE size_t flatten(const vec_t pos) const {
-    size_t base = 0;
-    for (const auto &node : nodes) {
-      if (!node.oob(pos))
-        return base + node.flatten(pos);
-      base += node.elem();
-    }
-    return 0;
+    const int k = this->find(pos);
+    if (k < 0)
+      return 0;
     //    throw std::invalid_argument("out of bounds");
+    return this->offset[k] + this->nodes[k].flatten(pos);
   }
 
   GPU_ENABLE vec_t unflatten(const size_t index) const {
-    size_t base = 0;
-    for (const auto &node : nodes) {
-      if (index - base < node.elem())
-        return node.unflatten(index - base);
-      else
-        base += node.elem();
-    }
-    /*
-    size_t base = 0;
-      if(!node.oob(pos))
-        return base + node.flatten(pos);
-      base += node.elem();
-    }
-    return -1;
-    */
-    return vec_t{0};
+    // Binary Search: Last Node with offset <= index
+    const auto it = std::upper_bound(this->offset.begin(), this->offset.end(), index);
+    const size_t k = (it - this->offset.begin()) - 1;
+    if (k >= this->nodes.size())
+      return vec_t{0};
+    return this->nodes[k].unflatten(index - this->offset[k]);
   }
 
   GPU_ENABLE bool oob(const vec_t pos) const {
-    for (const auto &node : nodes)
-      if (!node.oob(pos))
-        return false;
-    return true;
+    return this->find(pos) < 0;
   }
 
   // Data Inspection Interface
@@ -125,25 +111,96 @@ struct quad: indexbase {
   GPU_ENABLE vec_t ext() const noexcept { return this->_ext; }
 
   GPU_ENABLE inline size_t elem() const {
-    size_t count = 0;
-    for (const auto &node : nodes)
-      count += node.elem();
-    return count;
+    return this->offset.back();
   }
 
-  yield<vec_t> iter() const {
-    for (const auto &node : nodes)
-      for (size_t i = 0; i < node.elem(); ++i)
-        co_yield node.unflatten(i);
-    co_return;
+  //! Position Range (Node Order)
+  //! Note: The range references the quad and should not outlive it.
+  range_t<unflatten_t<const quad *>> iter() const {
+    return range_t<unflatten_t<const quad *>>({this}, this->elem());
   }
 
 private:
+  //! Node Lookup: Index of the first Node containing the Position,
+  //!   or -1 if no Node contains it. Only the Nodes which overlap the
+  //!   Grid Cell of the Position are tested, in their original order.
+  int find(const vec_t pos) const {
+    for (size_t d = 0; d < D; ++d)
+      if (pos[d] < this->_min[d] || pos[d] >= this->_max[d])
+        return -1;
+    const vec_t c = (pos - this->_min) / this->cell;
+    const size_t g = c[0] * this->grid[1] + c[1];
+    for (size_t i = this->cell_offset[g]; i < this->cell_offset[g + 1]; ++i) {
+      const int k = this->cell_nodes[i];
+      if (!this->nodes[k].oob(pos))
+        return k;
+    }
+    return -1;
+  }
+
+  //! Build the Element Offset Table and the Spatial Lookup Grid
+  //!
+  //! The grid cell size starts at the smallest node extent, so that
+  //! a cell overlaps only a few nodes, and is doubled until the grid
+  //! has at most 64 cells per node. The nodes overlapping every cell
+  //! are stored as a compressed sparse row list.
+  void build() {
+
+    this->offset.assign(1, 0);
+    for (const auto &node : this->nodes)
+      this->offset.push_back(this->offset.back() + node.elem());
+
+    if (this->nodes.empty())
+      return;
+
+    this->cell = vec_t(INT_MAX);
+    for (const auto &node : this->nodes)
+      this->cell = glm::min(this->cell, node.ext());
+    this->cell = glm::max(this->cell, vec_t(1));
+
+    this->grid = (this->_ext + this->cell - vec_t(1)) / this->cell;
+    while (size_t(this->grid[0]) * size_t(this->grid[1]) > 64 * this->nodes.size()) {
+      this->cell *= 2;
+      this->grid = (this->_ext + this->cell - vec_t(1)) / this->cell;
+    }
+
+    // Count, Scan and Fill Cell Lists (in Node Order)
+
+    const size_t n_cells = size_t(this->grid[0]) * size_t(this->grid[1]);
+    this->cell_offset.assign(n_cells + 1, 0);
+
+    const auto overlap = [this](const node_t &node, auto &&func) {
+      if (node.elem() == 0)
+        return;
+      const vec_t cmin = (node.min() - this->_min) / this->cell;
+      const vec_t cmax = (node.max() - vec_t(1) - this->_min) / this->cell;
+      for (int x = cmin[0]; x <= cmax[0]; ++x)
+        for (int y = cmin[1]; y <= cmax[1]; ++y)
+          func(size_t(x) * this->grid[1] + y);
+    };
+
+    for (const auto &node : this->nodes)
+      overlap(node, [this](const size_t g) { ++this->cell_offset[g + 1]; });
+
+    for (size_t g = 0; g < n_cells; ++g)
+      this->cell_offset[g + 1] += this->cell_offset[g];
+
+    std::vector<size_t> cursor(this->cell_offset.begin(), this->cell_offset.end() - 1);
+    this->cell_nodes.resize(this->cell_offset.back());
+    for (size_t k = 0; k < this->nodes.size(); ++k)
+      overlap(this->nodes[k], [&](const size_t g) { this->cell_nodes[cursor[g]++] = k; });
+  }
+
   std::vector<node_t> nodes;   //!< Vector of Nodes
   vec_t _min = vec_t(INT_MAX); //!< Min Position of Quad (World)
   vec_t _max = vec_t(INT_MIN); //!< Max Position of Quad (World)
   vec_t _ext = vec_t(0);       //!< Total Extent of Quad (World)
-  size_t area = 0;
+
+  std::vector<size_t> offset{0};   //!< Element Offset of each Node (Prefix Sum)
+  vec_t cell = vec_t(1);           //!< Lookup Grid Cell Size
+  vec_t grid = vec_t(0);           //!< Lookup Grid Extent (Cells)
+  std::vector<size_t> cell_offset; //!< Node Range of each Cell (CSR)
+  std::vector<int> cell_nodes;     //!< Node Indices of each Cell (CSR)
 };
 
 } // end of namespace soil
@@ -0,0 +1,133 @@
+#ifndef SOILLIB_INDEX_TILED
+#define SOILLIB_INDEX_TILED
+
+#include <soillib/core/types.hpp>
+#include <soillib/index/flat.hpp>
+#include <soillib/soillib.hpp>
+#include <soillib/util/range.hpp>
+
+#include <stdexcept>
+
+namespace soil {
+
+//! tiled_t<D> is a D-dimensional extent with blocked (tiled) layout
+//!
+//! the extent is partitioned into a grid of equally sized tiles,
+//! which are stored consecutively in row-major order of the grid.
+//! the cells of each tile are again stored in row-major order, so
+//! that neighborhoods are mostly contained in a single tile.
+//!
+//! tiles at the upper edges of the extent are padded to the full
+//! tile size, so that elem() can exceed the number of positions
+//! and flatten / unflatten are constant-time. Padding cells are
+//! never returned by iter(), which walks the extent tile by tile.
+//!
+//! Note: Only the 2D layout is a registered index type (TILED2).
+//!
+template<size_t D>
+struct tiled_t: indexbase {
+
+  static_assert(D == 2, "only tiled_t<2> is a registered index type");
+  typedef glm::vec<D, int> vec_t;
+
+  tiled_t() = default;
+  tiled_t(const vec_t _vec, const vec_t _tile): _vec{_vec},
+                                                _tile{_tile} {
+    for (size_t d = 0; d < D; ++d) {
+      if (_tile[d] <= 0)
+        throw std::invalid_argument("tile extent must be positive");
+      if (_vec[d] < 0)
+        throw std::invalid_argument("extent must not be negative");
+    }
+    this->_grid = (_vec + _tile - vec_t(1)) / _tile;
+  }
+
+  static constexpr size_t n_dims = D;
+
+  //! Number of Dimensions
+  static constexpr size_t dims() noexcept {
+    return D;
+  }
+
+  constexpr soil::dindex type() noexcept override {
+    return soil::dindex::TILED2;
+  }
+
+  //! Number of Elements (incl. Padding)
+  GPU_ENABLE inline size_t elem() const {
+    return this->grid().elem() * this->cell().elem();
+  }
+
+  GPU_ENABLE vec_t min() const noexcept { return vec_t{0}; }
+  GPU_ENABLE vec_t max() const noexcept { return this->_vec; }
+  GPU_ENABLE vec_t ext() const noexcept { return this->_vec; }
+  GPU_ENABLE vec_t tile() const noexcept { return this->_tile; }
+
+  //! Extent Subscript Operator
+  GPU_ENABLE inline size_t operator[](const size_t d) const {
+    return this->_vec[d];
+  }
+
+  // Flattening / Unflattening
+
+  GPU_ENABLE size_t flatten(const vec_t pos) const {
+    const vec_t tile = pos / this->_tile;
+    const size_t t = this->grid().flatten(tile);
+    const size_t c = this->cell().flatten(pos - tile * this->_tile);
+    return t * this->cell().elem() + c;
+  }
+
+  GPU_ENABLE vec_t unflatten(const size_t index) const {
+    const size_t n = this->cell().elem();
+    const vec_t t = this->grid().unflatten(index / n);
+    const vec_t c = this->cell().unflatten(index % n);
+    return t * this->_tile + c;
+  }
+
+  //! Out-Of-Bounds Check (Compact)
+  GPU_ENABLE bool oob(const vec_t pos) const {
+    for (size_t d = 0; d < D; ++d)
+      if (pos[d] < 0 || pos[d] >= this->_vec[d])
+        return true;
+    return false;
+  }
+
+  //! compact_t enumerates the positions of the extent tile by tile,
+  //! without padding: the k-th position is computed in closed form,
+  //! as all tiles before it in the row of tiles (and all rows of
+  //! tiles before it) are full in the dimension it is counted in.
+  struct compact_t {
+    vec_t ext;
+    vec_t tile;
+    GPU_ENABLE vec_t unflatten(const size_t k) const {
+      const size_t band = size_t(tile[0]) * size_t(ext[1]); // Cells per Full Row of Tiles
+      const int r = int(k / band);
+      const size_t kr = k - size_t(r) * band;
+      const int h = glm::min(tile[0], ext[0] - r * tile[0]); // Height of the Row of Tiles
+      const int c = int(kr / (size_t(h) * size_t(tile[1])));
+      const size_t kc = kr - size_t(c) * size_t(h) * size_t(tile[1]);
+      const int w = glm::min(tile[1], ext[1] - c * tile[1]); // Width of the Tile
+      return vec_t(r * tile[0] + int(kc / w), c * tile[1] + int(kc % w));
+    }
+  };
+
+  //! Position Range
+  //!
+  //! This returns a random-access range, which iterates
+  //! over the set of positions tile by tile, skipping padding.
+  range_t<unflatten_t<compact_t>> iter() const {
+    return range_t<unflatten_t<compact_t>>({compact_t{this->_vec, this->_tile}}, size_t(this->_vec[0]) * size_t(this->_vec[1]));
+  }
+
+private:
+  GPU_ENABLE flat_t<D> grid() const { return flat_t<D>(this->_grid); }
+  GPU_ENABLE flat_t<D> cell() const { return flat_t<D>(this->_tile); }
+
+  vec_t _vec;  //!< Extent of the Index
+  vec_t _tile; //!< Extent of a Single Tile
+  vec_t _grid; //!< Number of Tiles per Dimension
+};
+
+} // end of namespace soil
+
+#endif
@@ -0,0 +1,419 @@
+#ifndef SOILLIB_IO_ARCHIVE
+#define SOILLIB_IO_ARCHIVE
+
+#include <soillib/core/buffer.hpp>
+#include <soillib/core/index.hpp>
+#include <soillib/io/geotiff.hpp>
+#include <soillib/util/error.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace soil {
+namespace io {
+
+//! Memory Mapping Access Mode
+enum access_t {
+  READONLY,   //!< Shared, Read-Only Mapping (Writes Fault)
+  COPYONWRITE //!< Private Mapping (Writes are not Persisted)
+};
+
+//! archive is a native .soil container of named arrays, which
+//! is loaded by memory mapping, without copying the raw data.
+//!
+//! Every array stores its buffer type, index type and extent,
+//! and the archive stores the (optional) GeoTIFF metadata. The raw
+//! data of each array is page-aligned, so that the buffers of a
+//! loaded archive point directly into the mapping of the file,
+//! which is shared with the page cache of other processes.
+//!
+//! The mapping is released when the last buffer which references
+//! it is destroyed. Read-only archives must not be modified in
+//! place, while copy-on-write archives copy modified pages only.
+//!
+//! File Layout:
+//!
+//!   header_t, entry_t[count], meta, (padding), data[0], data[1], ...
+//!
+//! Usage:
+//!
+//! soil::io::archive archive;
+//! archive.add("height", model.height, model.index);
+//! archive.write("state.soil");
+//!
+//! soil::io::archive state("state.soil");
+//! soil::buffer height = state.buffer("height");
+//!
+struct archive {
+
+  static constexpr size_t align = 4096;  //!< Alignment of Array Data
+  static constexpr uint32_t version = 1; //!< File Format Version
+
+  archive() {}
+  archive(const char *filename, const access_t access = COPYONWRITE) {
+    read(filename, access);
+  }
+
+  //! Add or Replace a Named Array
+  void add(const std::string &name, const soil::buffer &buffer, const soil::index &index);
+
+  void read(const char *filename, const access_t access = COPYONWRITE); //!< Map .soil File
+  bool write(const char *filename) const;                               //!< Write .soil File
+
+  std::vector<std::string> names() const;
+  bool has(const std::string &name) const { return this->find(name) >= 0; }
+  soil::buffer buffer(const std::string &name) const { return this->at(name).buffer; }
+  soil::index index(const std::string &name) const { return this->at(name).index; }
+
+  soil::io::geotiff::meta_t meta; //!< GeoTIFF Metadata
+
+private:
+  //! File Header
+  struct header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;     //!< Number of Arrays
+    uint64_t meta_size; //!< Size of Serialized Metadata
+  };
+
+  //! Array Directory Entry
+  struct entry_t {
+    char name[64];
+    uint32_t type;  //!< soil::dtype
+    uint32_t index; //!< soil::dindex
+    int32_t ext[4]; //!< Index Extent
+    int32_t tile[2];
+    uint64_t offset; //!< Byte Offset of Data (Aligned)
+    uint64_t size;   //!< Byte Size of Data
+  };
+
+  struct array_t {
+    std::string name;
+    soil::buffer buffer;
+    soil::index index;
+  };
+
+  int find(const std::string &name) const {
+    for (size_t i = 0; i < this->arrays.size(); ++i)
+      if (this->arrays[i].name == name)
+        return i;
+    return -1;
+  }
+
+  const array_t &at(const std::string &name) const {
+    const int i = this->find(name);
+    if (i < 0)
+      throw std::invalid_argument("archive has no array named " + name);
+    return this->arrays[i];
+  }
+
+  static std::string pack(const soil::io::geotiff::meta_t &meta);
+  static void unpack(soil::io::geotiff::meta_t &meta, const char *data, const size_t size);
+
+  std::vector<array_t> arrays;
+};
+
+// Implementations
+
+inline void archive::add(const std::string &name, const soil::buffer &buffer, const soil::index &index) {
+
+  if (name.empty() || name.size() >= sizeof(entry_t::name))
+    throw std::invalid_argument("archive array names must have 1 to 63 characters");
+
+  if (buffer.host() != soil::host_t::CPU)
+    throw soil::error::mismatch_host(soil::host_t::CPU, buffer.host());
+
+  if (buffer.elem() != index.elem())
+    throw soil::error::mismatch_size(index.elem(), buffer.elem());
+
+  if (index.type() == soil::dindex::QUAD)
+    throw std::invalid_argument("archive does not support quad indices");
+
+  const int i = this->find(name);
+  if (i >= 0)
+    this->arrays[i] = {name, buffer, index};
+  else
+    this->arrays.push_back({name, buffer, index});
+}
+
+inline std::vector<std::string> archive::names() const {
+  std::vector<std::string> names;
+  for (const auto &array : this->arrays)
+    names.push_back(array.name);
+  return names;
+}
+
+//! Write .soil File
+//!
+//! The file is written to a temporary file next to the target,
+//! which then replaces it. Buffers mapped from an earlier version
+//! of the file keep the old file, so that the archive can be
+//! written to the same file that it was read from.
+inline bool archive::write(const char *filename) const {
+
+  const std::string meta = archive::pack(this->meta);
+
+  header_t header{};
+  std::memcpy(header.magic, "SOILLIB", 8);
+  header.version = archive::version;
+  header.count = this->arrays.size();
+  header.meta_size = meta.size();
+
+  // Directory with Aligned Data Offsets
+
+  std::vector<entry_t> entries(this->arrays.size());
+  size_t offset = sizeof(header_t) + entries.size() * sizeof(entry_t) + meta.size();
+
+  for (size_t i = 0; i < this->arrays.size(); ++i) {
+    const array_t &array = this->arrays[i];
+    entry_t &entry = entries[i];
+
+    std::strncpy(entry.name, array.name.c_str(), sizeof(entry.name) - 1);
+    entry.type = array.buffer.type();
+    entry.index = array.index.type();
+
+    soil::select(array.index.type(), [&]<typename I>() {
+      const I &index = array.index.as<I>();
+      for (size_t d = 0; d < I::n_dims; ++d)
+        entry.ext[d] = index.ext()[d];
+      if constexpr (std::same_as<I, soil::tiled_t<2>>) {
+        entry.tile[0] = index.tile()[0];
+        entry.tile[1] = index.tile()[1];
+      }
+    });
+
+    offset = (offset + align - 1) / align * align;
+    entry.offset = offset;
+    entry.size = array.buffer.size();
+    offset += entry.size;
+  }
+
+  const std::string temp = std::string(filename) + ".tmp";
+  std::ofstream out(temp, std::ios::binary);
+  if (!out)
+    throw soil::error::missing_file(temp.c_str());
+
+  out.write((const char *)&header, sizeof(header_t));
+  out.write((const char *)entries.data(), entries.size() * sizeof(entry_t));
+  out.write(meta.data(), meta.size());
+
+  size_t end = sizeof(header_t) + entries.size() * sizeof(entry_t) + meta.size();
+  for (size_t i = 0; i < this->arrays.size(); ++i) {
+    if (entries[i].size == 0)
+      continue;
+    out.seekp(entries[i].offset);
+    soil::buffer buffer = this->arrays[i].buffer;
+    out.write((const char *)buffer.data(), entries[i].size);
+    end = entries[i].offset + entries[i].size;
+  }
+
+  // Note: Pad the File to the End of the Last Array, so
+  //  that the offset of an empty last array is in range.
+  if (end < offset) {
+    out.seekp(offset - 1);
+    out.put(0);
+  }
+
+  out.flush();
+  out.close();
+  if (!out || std::rename(temp.c_str(), filename) != 0) {
+    std::remove(temp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+//! Map .soil File
+//!
+//! The file is mapped in full, and the buffers of the arrays point
+//! into the mapping, which they share ownership of. No data is read
+//! until it is accessed, so that opening an archive is independent
+//! of its size.
+inline void archive::read(const char *filename, const access_t access) {
+
+  const int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    throw soil::error::missing_file(filename);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(header_t)) {
+    ::close(fd);
+    throw std::invalid_argument("invalid .soil file");
+  }
+
+  const size_t length = st.st_size;
+  const int prot = (access == READONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+  const int flags = (access == READONLY) ? MAP_SHARED : MAP_PRIVATE;
+  void *base = mmap(NULL, length, prot, flags, fd, 0);
+  ::close(fd); // Note: The Mapping keeps the File Open
+
+  if (base == MAP_FAILED)
+    throw std::runtime_error("failed to map .soil file");
+
+  std::shared_ptr<void> mapping(base, [length](void *base) {
+    munmap(base, length);
+  });
+
+  // Validate the Header and Directory
+  //  Note: Ranges are checked by subtraction, and element
+  //  counts with overflow checks, so that the fields of a
+  //  corrupt file can't overflow.
+
+  const auto fits = [length](const uint64_t offset, const uint64_t size) {
+    return offset <= length && size <= length - offset;
+  };
+
+  const char *data = (const char *)base;
+  header_t header;
+  std::memcpy(&header, data, sizeof(header_t));
+
+  if (std::memcmp(header.magic, "SOILLIB", 8) != 0 || header.version != archive::version)
+    throw std::invalid_argument("invalid .soil file");
+
+  if (!fits(sizeof(header_t), uint64_t(header.count) * sizeof(entry_t)))
+    throw std::invalid_argument("invalid .soil file");
+
+  const size_t meta_offset = sizeof(header_t) + size_t(header.count) * sizeof(entry_t);
+  if (!fits(meta_offset, header.meta_size))
+    throw std::invalid_argument("invalid .soil file");
+
+  std::vector<entry_t> entries(header.count);
+  std::memcpy(entries.data(), data + sizeof(header_t), entries.size() * sizeof(entry_t));
+
+  this->arrays.clear();
+  this->meta = soil::io::geotiff::meta_t();
+  archive::unpack(this->meta, data + meta_offset, header.meta_size);
+
+  for (const entry_t &entry : entries) {
+
+    if (entry.offset % align != 0 || !fits(entry.offset, entry.size))
+      throw std::invalid_argument("invalid .soil file");
+
+    for (const int32_t ext : entry.ext)
+      if (ext < 0)
+        throw std::invalid_argument("invalid .soil file");
+
+    // Number of Elements (incl. Tile Padding), Checked for Overflow
+
+    const soil::dindex type = soil::dindex(entry.index);
+    const size_t dims = (type == soil::dindex::FLAT1) ? 1 : (type == soil::dindex::FLAT3) ? 3 : (type == soil::dindex::FLAT4) ? 4 : 2;
+
+    if (type == soil::dindex::TILED2 && (entry.tile[0] <= 0 || entry.tile[1] <= 0))
+      throw std::invalid_argument("invalid .soil file");
+
+    uint64_t elem = 1;
+    for (size_t d = 0; d < dims; ++d) {
+      uint64_t ext = uint64_t(entry.ext[d]);
+      if (type == soil::dindex::TILED2)
+        ext = (ext + entry.tile[d] - 1) / entry.tile[d] * entry.tile[d];
+      if (__builtin_mul_overflow(elem, ext, &elem))
+        throw std::invalid_argument("invalid .soil file");
+    }
+
+    // Index from Type and Extent
+
+    soil::index index;
+    if (type == soil::dindex::FLAT1)
+      index = soil::index(soil::index::vec_t<1>(entry.ext[0]));
+    else if (type == soil::dindex::FLAT2)
+      index = soil::index(soil::index::vec_t<2>(entry.ext[0], entry.ext[1]));
+    else if (type == soil::dindex::FLAT3)
+      index = soil::index(soil::index::vec_t<3>(entry.ext[0], entry.ext[1], entry.ext[2]));
+    else if (type == soil::dindex::FLAT4)
+      index = soil::index(soil::index::vec_t<4>(entry.ext[0], entry.ext[1], entry.ext[2], entry.ext[3]));
+    else if (type == soil::dindex::MORTON) {
+      const soil::morton_t morton(glm::ivec2(entry.ext[0], entry.ext[1]));
+      elem = morton.elem(); // Note: Bounded Padding (see morton_t)
+      index = soil::index(morton);
+    }
+    else if (type == soil::dindex::TILED2)
+      index = soil::index(soil::tiled_t<2>(glm::ivec2(entry.ext[0], entry.ext[1]), glm::ivec2(entry.tile[0], entry.tile[1])));
+    else
+      throw std::invalid_argument("invalid .soil file");
+
+    // Buffer in the Mapping
+
+    soil::buffer buffer = soil::select(soil::dtype(entry.type), [&]<typename T>() -> soil::buffer {
+      if (elem > (length - entry.offset) / sizeof(T) || entry.size != elem * sizeof(T))
+        throw std::invalid_argument("invalid .soil file");
+      return soil::buffer_t<T>((T *)(data + entry.offset), elem, mapping, access == READONLY);
+    });
+
+    this->arrays.push_back({std::string(entry.name, strnlen(entry.name, sizeof(entry.name))), buffer, index});
+  }
+}
+
+//! Serialize GeoTIFF Metadata (Length-Prefixed Fields)
+inline std::string archive::pack(const soil::io::geotiff::meta_t &meta) {
+
+  std::string data;
+  const auto put = [&data](const void *ptr, const uint64_t size) {
+    data.append((const char *)&size, sizeof(uint64_t));
+    data.append((const char *)ptr, size);
+  };
+
+  put(meta.gdal_nodata.data(), meta.gdal_nodata.size());
+  put(meta.gdal_metadata.data(), meta.gdal_metadata.size());
+  put(meta.geoasciiparams.data(), meta.geoasciiparams.size());
+  put(meta.scale.data(), meta.scale.size() * sizeof(double));
+  put(meta.coords.data(), meta.coords.size() * sizeof(double));
+  put(meta.params.data(), meta.params.size() * sizeof(double));
+  put(meta.keydir.data(), meta.keydir.size() * sizeof(short));
+
+  const uint64_t dims[3] = {meta.width, meta.height, meta.bits};
+  put(dims, sizeof(dims));
+  return data;
+}
+
+//! Deserialize GeoTIFF Metadata
+inline void archive::unpack(soil::io::geotiff::meta_t &meta, const char *data, const size_t size) {
+
+  size_t pos = 0;
+  const auto get = [&]<typename T>(std::vector<T> &out) {
+    uint64_t n = 0;
+    if (pos + sizeof(uint64_t) > size)
+      throw std::invalid_argument("invalid .soil file");
+    std::memcpy(&n, data + pos, sizeof(uint64_t));
+    pos += sizeof(uint64_t);
+    if (n > size - pos || n % sizeof(T) != 0)
+      throw std::invalid_argument("invalid .soil file");
+    out.resize(n / sizeof(T));
+    std::memcpy(out.data(), data + pos, n);
+    pos += n;
+  };
+
+  std::vector<char> text;
+  get(text);
+  meta.gdal_nodata = std::string(text.begin(), text.end());
+  get(text);
+  meta.gdal_metadata = std::string(text.begin(), text.end());
+  get(text);
+  meta.geoasciiparams = std::string(text.begin(), text.end());
+  get(meta.scale);
+  get(meta.coords);
+  get(meta.params);
+  get(meta.keydir);
+
+  std::vector<uint64_t> dims;
+  get(dims);
+  if (dims.size() != 3)
+    throw std::invalid_argument("invalid .soil file");
+  meta.width = dims[0];
+  meta.height = dims[1];
+  meta.bits = dims[2];
+}
+
+} // end of namespace io
+} // end of namespace soil
+
+#endif
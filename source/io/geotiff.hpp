@@ -81,14 +81,17 @@ struct geotiff: soil::io::tiff {
 
   bool peek(const char *filename);
   bool read(const char *filename);
+  bool read(const char *filename, const glm::ivec2 min, const glm::ivec2 ext);
+  bool read(const char *filename, const size_t level);
   bool write(const char *filename);
+  bool write(const char *filename, const options_t &options);
 
   //! GeoTIFF Metadata Type
   struct meta_t {
     std::string filename;
-    size_t width;
-    size_t height;
-    size_t bits;
+    size_t width = 0;
+    size_t height = 0;
+    size_t bits = 0;
 
     std::string gdal_nodata;
     std::string gdal_metadata;
@@ -188,21 +191,62 @@ bool geotiff::read(const char *filename) {
   return true;
 }
 
+//! Read a Window of GeoTIFF Data
+//!
+//! The tie point is moved to the window origin, following the
+//! GeoTIFF raster convention (x grows with columns, y shrinks
+//! with rows), so that the window can be written out georeferenced.
+bool geotiff::read(const char *filename, const glm::ivec2 min, const glm::ivec2 ext) {
+
+  geotiff::peek(filename);
+  if (!tiff::read(filename, min, ext))
+    return false;
+
+  const glm::ivec2 wmin = glm::clamp(min, glm::ivec2(0), glm::ivec2(this->_meta.height, this->_meta.width));
+  this->_meta.coords[3] += this->_meta.scale[0] * wmin[1];
+  this->_meta.coords[4] -= this->_meta.scale[1] * wmin[0];
+  this->_meta.width = this->width();
+  this->_meta.height = this->height();
+
+  geotiff::setNaN();
+  return true;
+}
+
+//! Read a GeoTIFF Overview Level
+//!
+//! The tie point is kept, and the pixel scale is adjusted
+//! to the extent of the overview relative to the image.
+bool geotiff::read(const char *filename, const size_t level) {
+
+  geotiff::peek(filename);
+  if (!tiff::read(filename, level))
+    return false;
+
+  this->_meta.scale[0] *= double(this->_meta.width) / double(this->width());
+  this->_meta.scale[1] *= double(this->_meta.height) / double(this->height());
+  this->_meta.width = this->width();
+  this->_meta.height = this->height();
+
+  geotiff::setNaN();
+  return true;
+}
+
 bool geotiff::write(const char *filename) {
+  return this->write(filename, options_t{});
+}
+
+bool geotiff::write(const char *filename, const options_t &options) {
 
   _XTIFFInitialize();
 
-  TIFF *out = TIFFOpen(filename, "w");
+  TIFF *out = this->open(filename, options);
 
-  TIFFSetField(out, TIFFTAG_IMAGEWIDTH, this->width());
-  TIFFSetField(out, TIFFTAG_IMAGELENGTH, this->height());
-  TIFFSetField(out, TIFFTAG_SAMPLESPERPIXEL, 1);
-  TIFFSetField(out, TIFFTAG_BITSPERSAMPLE, this->bits());
-  TIFFSetField(out, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-  TIFFSetField(out, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-  TIFFSetField(out, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-  TIFFSetField(out, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
-  TIFFSetField(out, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(out, this->width()));
+  try {
+    this->write_fields(out, options);
+  } catch (...) {
+    TIFFClose(out);
+    throw;
+  }
 
   // GDAL Tags
 
@@ -222,92 +266,61 @@ bool geotiff::write(const char *filename) {
   if (!_meta.geoasciiparams.empty())
     TIFFSetField(out, TIFFTAG_GEOASCIIPARAMS, _meta.geoasciiparams.c_str());
 
-  // Output Data
-
-  auto data = this->_buffer.data();
-  uint8_t *buf = (uint8_t *)data;
-
-  for (uint32_t row = 0; row < this->height(); row++) {
-    if (TIFFWriteScanline(out, buf, row, 0) < 0)
-      break;
-    buf += this->width() * (this->bits() / 8);
+  // Output Data: Overviews exclude the NoData Value
+
+  bool result = false;
+  try {
+    std::optional<double> nodata;
+    if (!_meta.gdal_nodata.empty())
+      nodata = std::stod(_meta.gdal_nodata);
+    result = this->write_data(out, options) && this->write_overviews(out, options, nodata);
+  } catch (...) {
+    TIFFClose(out);
+    throw;
   }
 
   TIFFClose(out);
-  return true;
+  return result;
 }
 
+//! Set Available NoData Values to NaN
+//!
+//! Note: Integer samples have no NaN, so that their
+//!  NoData values are kept as they are.
 void geotiff::setNaN() {
 
   if (this->_meta.gdal_nodata == "")
     return;
 
-  if (this->bits() == 16) {
-    auto nan = std::numeric_limits<float>::quiet_NaN();
-    auto buffer = this->_buffer.as<float>();
-    const float _nodata = std::stof(this->_meta.gdal_nodata);
-    for (size_t i = 0; i < buffer.elem(); ++i) {
-      if (buffer[i] == _nodata)
-        buffer[i] = nan;
-    }
-  }
-
-  if (this->bits() == 32) {
-    auto nan = std::numeric_limits<float>::quiet_NaN();
-    auto buffer = this->_buffer.as<float>();
-    const float _nodata = std::stof(this->_meta.gdal_nodata);
-    for (size_t i = 0; i < buffer.elem(); ++i) {
-      if (buffer[i] == _nodata)
-        buffer[i] = nan;
-    }
-  }
-
-  if (this->bits() == 64) {
-    auto nan = std::numeric_limits<double>::quiet_NaN();
-    auto buffer = this->_buffer.as<double>();
-    const double _nodata = std::stod(this->_meta.gdal_nodata);
-    for (size_t i = 0; i < buffer.elem(); ++i) {
-      if (buffer[i] == _nodata)
-        buffer[i] = nan;
+  soil::select(this->_buffer.type(), [&]<typename T>() {
+    if constexpr (std::is_floating_point_v<T> || std::is_same_v<T, soil::half>) {
+      auto buffer = this->_buffer.as<T>();
+      const T nan = std::numeric_limits<T>::quiet_NaN();
+      const T _nodata = T(std::stod(this->_meta.gdal_nodata));
+      for (size_t i = 0; i < buffer.elem(); ++i) {
+        if (buffer[i] == _nodata)
+          buffer[i] = nan;
+      }
     }
-  }
+  });
 }
 
+//! Reset NaN Values to the Available NoData Value
 void geotiff::unsetNaN() {
 
   if (this->_meta.gdal_nodata == "")
     return;
 
-  if (this->bits() == 16) {
-    auto nan = std::numeric_limits<float>::quiet_NaN();
-    auto buffer = this->_buffer.as<float>();
-    const float _nodata = std::stof(this->_meta.gdal_nodata);
-    for (size_t i = 0; i < buffer.elem(); ++i) {
-      if (buffer[i] == nan) {
-        buffer[i] = _nodata;
+  soil::select(this->_buffer.type(), [&]<typename T>() {
+    if constexpr (std::is_floating_point_v<T> || std::is_same_v<T, soil::half>) {
+      auto buffer = this->_buffer.as<T>();
+      const T _nodata = T(std::stod(this->_meta.gdal_nodata));
+      for (size_t i = 0; i < buffer.elem(); ++i) {
+        if (buffer[i] != buffer[i]) // Note: Only NaN is Unequal to Itself
+          buffer[i] = _nodata;
       }
     }
-  }
-
-  if (this->bits() == 32) {
-    auto nan = std::numeric_limits<float>::quiet_NaN();
-    auto buffer = this->_buffer.as<float>();
-    const float _nodata = std::stof(this->_meta.gdal_nodata);
-    for (size_t i = 0; i < buffer.elem(); ++i) {
-      if (buffer[i] == nan)
-        buffer[i] = _nodata;
-    }
-  }
-
-  if (this->bits() == 64) {
-    auto nan = std::numeric_limits<double>::quiet_NaN();
-    auto buffer = this->_buffer.as<double>();
-    const double _nodata = std::stod(this->_meta.gdal_nodata);
-    for (size_t i = 0; i < buffer.elem(); ++i) {
-      if (buffer[i] == nan)
-        buffer[i] = _nodata;
-    }
-  }
+  });
 }
 
 }; // end of namespace io
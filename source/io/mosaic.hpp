@@ -0,0 +1,422 @@
+#ifndef SOILLIB_IO_MOSAIC
+#define SOILLIB_IO_MOSAIC
+
+#include <soillib/core/buffer.hpp>
+#include <soillib/core/index.hpp>
+#include <soillib/io/geotiff.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace soil {
+namespace io {
+
+//! mosaic is a virtual raster over a collection of GeoTIFF tiles,
+//! which answers windowed reads in world-space without loading
+//! the full collection into memory.
+//!
+//! The tile footprints are loaded from the metadata (peek) only,
+//! and are stored in a uniform lookup grid. A read decodes only the
+//! blocks of the tiles which overlap the requested rectangle, which
+//! are kept in a least-recently-used cache of bounded size. Blocks
+//! are the native strips or tiles of each file, so that every block
+//! is decoded once, and the metadata is kept to decode without a peek.
+//!
+//! All tiles must share the pixel scale and be aligned to a common
+//! pixel grid, whose origin is the top-left corner of the collection.
+//! World-space follows the GeoTIFF raster convention, i.e. x grows
+//! with the columns and y shrinks with the rows. Where tiles overlap,
+//! the first valid value in the order of the files is kept, where
+//! NaN and the NoData value of each tile (GDAL_NODATA) are invalid,
+//! so that integer tiles don't contribute their NoData samples.
+//!
+//! Note: A mosaic is not thread-safe, but each read gathers the
+//! blocks which are not cached and decodes them in parallel on the
+//! host thread pool.
+//!
+//! Usage:
+//!
+//! soil::io::mosaic mosaic("dem/", 1 << 30);
+//! soil::io::geotiff window = mosaic.read(min, max);
+//! window.write("window.tiff");
+//!
+struct mosaic {
+
+  mosaic(const std::vector<std::string> &files, const size_t cache = size_t(1) << 28);
+  mosaic(const char *directory, const size_t cache = size_t(1) << 28);
+
+  //! Read all Data in the World-Space Rectangle [min, max)
+  soil::io::geotiff read(const glm::dvec2 min, const glm::dvec2 max);
+
+  size_t size() const { return this->tiles.size(); } //!< Number of Tiles
+  size_t cached() const { return this->_bytes; }     //!< Bytes in the Cache
+
+  glm::dvec2 min() const { return this->_min; }     //!< World-Space Minimum
+  glm::dvec2 max() const { return this->_max; }     //!< World-Space Maximum
+  glm::dvec2 scale() const { return this->_scale; } //!< World-Space Pixel Scale
+  glm::ivec2 ext() const { return this->_ext; }     //!< Pixel Extent (Row, Column)
+
+private:
+  //! Tile Footprint in the Mosaic Pixel Grid
+  struct tile_t {
+    std::string filename;
+    glm::ivec2 min;        //!< Pixel Offset (Row, Column)
+    glm::ivec2 ext;        //!< Pixel Extent (Row, Column)
+    size_t key;            //!< Cache Key of the First Block
+    glm::ivec2 block;      //!< Native Block Extent (Strip or Tile)
+    double nodata;         //!< NoData Value (NaN if None)
+    soil::io::tiff header; //!< Metadata of the File (Decoding)
+  };
+
+  //! Block of a Tile which is Decoded by a Read
+  struct miss_t {
+    size_t t;     //!< Tile Index
+    glm::ivec2 b; //!< Block Position in the Tile
+    size_t key;   //!< Cache Key
+  };
+
+  typedef std::unordered_map<size_t, soil::buffer> blocks_t;
+
+  static std::vector<std::string> list(const char *directory);
+  static size_t bytes(const soil::buffer &buffer) {
+    return buffer.size(); // Note: Blocks are Cached in their Sample Type
+  }
+
+  void build();
+  void load(const std::vector<size_t> &overlap, const glm::ivec2 wmin, const glm::ivec2 wmax, blocks_t &blocks);
+  void insert(const size_t key, const soil::buffer &buffer);
+
+  //! Blocks of a Tile which Intersect the Window [wmin, wmax)
+  std::pair<glm::ivec2, glm::ivec2> range(const size_t t, const glm::ivec2 wmin, const glm::ivec2 wmax) const;
+  size_t key(const size_t t, const glm::ivec2 b) const;
+
+  template<typename T>
+  void blit(T *out, const glm::ivec2 wmin, const glm::ivec2 wext, const size_t t, const blocks_t &blocks) const;
+
+  std::vector<tile_t> tiles;        //!< Tile Footprints
+  soil::io::geotiff::meta_t meta;   //!< Metadata of the First Tile
+  soil::dtype type = soil::FLOAT32; //!< Output Buffer Type
+
+  glm::dvec2 _min = glm::dvec2(DBL_MAX);  //!< World-Space Minimum
+  glm::dvec2 _max = glm::dvec2(-DBL_MAX); //!< World-Space Maximum
+  glm::dvec2 _scale = glm::dvec2(1.0);    //!< World-Space Pixel Scale
+  glm::ivec2 _ext = glm::ivec2(0);        //!< Pixel Extent (Row, Column)
+
+  // Uniform Lookup Grid (CSR)
+
+  glm::ivec2 cell = glm::ivec2(1);  //!< Grid Cell Size (Pixels)
+  glm::ivec2 grid = glm::ivec2(0);  //!< Grid Extent (Cells)
+  std::vector<size_t> cell_offset;  //!< Tile Range of each Cell
+  std::vector<size_t> cell_tiles;   //!< Tile Indices of each Cell
+
+  // LRU Block Cache
+
+  typedef std::pair<size_t, soil::buffer> entry_t;
+  std::list<entry_t> lru; //!< Cached Blocks, Most Recent First
+  std::unordered_map<size_t, std::list<entry_t>::iterator> lookup;
+  size_t _capacity = 0; //!< Cache Capacity (Bytes)
+  size_t _bytes = 0;    //!< Cache Size (Bytes)
+};
+
+inline mosaic::mosaic(const std::vector<std::string> &files, const size_t cache): _capacity{cache} {
+
+  if (files.empty())
+    throw std::invalid_argument("mosaic requires at least one tile");
+
+  // Load the Tile Footprints in World-Space
+
+  std::vector<glm::dvec2> origin;
+  for (const auto &file : files) {
+    soil::io::geotiff geotiff;
+    geotiff.peek(file.c_str());
+
+    const auto &meta = geotiff._meta;
+    const glm::dvec2 scale(meta.scale[0], meta.scale[1]);
+    if (this->tiles.empty()) {
+      this->_scale = scale;
+      this->meta = meta;
+      this->type = (geotiff.bits() == 64) ? soil::FLOAT64 : soil::FLOAT32;
+    }
+
+    const glm::dvec2 error = glm::abs(scale - this->_scale) / glm::abs(this->_scale);
+    if (error[0] > 1E-6 || error[1] > 1E-6)
+      throw std::invalid_argument("mosaic tiles must share the pixel scale");
+
+    // Note: The Tie Point is the Top-Left Corner
+    const glm::ivec2 ext(geotiff.height(), geotiff.width());
+    const glm::dvec2 tmin(meta.coords[3], meta.coords[4] - scale[1] * ext[0]);
+    const glm::dvec2 tmax(meta.coords[3] + scale[0] * ext[1], meta.coords[4]);
+
+    this->_min = glm::min(this->_min, tmin);
+    this->_max = glm::max(this->_max, tmax);
+    // Note: Integer samples keep their NoData values when read
+    const double nodata = meta.gdal_nodata.empty() ? std::numeric_limits<double>::quiet_NaN() : std::strtod(meta.gdal_nodata.c_str(), NULL);
+
+    this->tiles.push_back({file, glm::ivec2(0), ext, 0, geotiff.block(), nodata, geotiff});
+    origin.emplace_back(meta.coords[3], meta.coords[4]);
+  }
+
+  // Align the Tiles to the Pixel Grid of the Mosaic
+
+  for (size_t t = 0; t < this->tiles.size(); ++t) {
+    const glm::dvec2 offset = glm::dvec2(this->_max[1] - origin[t][1], origin[t][0] - this->_min[0]) / glm::dvec2(this->_scale[1], this->_scale[0]);
+    this->tiles[t].min = glm::ivec2(glm::round(offset));
+    this->_ext = glm::max(this->_ext, this->tiles[t].min + this->tiles[t].ext);
+  }
+
+  this->build();
+}
+
+inline mosaic::mosaic(const char *directory, const size_t cache): mosaic(mosaic::list(directory), cache) {}
+
+//! Sorted List of the .tif / .tiff Files in a Directory
+inline std::vector<std::string> mosaic::list(const char *directory) {
+  std::vector<std::string> files;
+  for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+    const auto ext = entry.path().extension();
+    if (ext == ".tif" || ext == ".tiff")
+      files.push_back(entry.path().string());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+//! Build the Block Cache Keys and the Tile Lookup Grid
+//!
+//! The cell size is the largest tile extent, so that every tile
+//! overlaps at most four cells, and the tiles of each cell are
+//! stored as a compressed sparse row list in the order of the files.
+inline void mosaic::build() {
+
+  size_t key = 0;
+  for (auto &tile : this->tiles) {
+    const glm::ivec2 blocks = (tile.ext + tile.block - glm::ivec2(1)) / tile.block;
+    tile.key = key;
+    key += size_t(blocks[0]) * size_t(blocks[1]);
+  }
+
+  for (const auto &tile : this->tiles)
+    this->cell = glm::max(this->cell, tile.ext);
+  this->grid = (this->_ext + this->cell - glm::ivec2(1)) / this->cell;
+
+  const size_t n_cells = size_t(this->grid[0]) * size_t(this->grid[1]);
+  this->cell_offset.assign(n_cells + 1, 0);
+
+  const auto overlap = [this](const tile_t &tile, auto &&func) {
+    const glm::ivec2 cmin = tile.min / this->cell;
+    const glm::ivec2 cmax = (tile.min + tile.ext - glm::ivec2(1)) / this->cell;
+    for (int x = cmin[0]; x <= cmax[0]; ++x)
+      for (int y = cmin[1]; y <= cmax[1]; ++y)
+        func(size_t(x) * this->grid[1] + y);
+  };
+
+  for (const auto &tile : this->tiles)
+    overlap(tile, [this](const size_t g) { ++this->cell_offset[g + 1]; });
+
+  for (size_t g = 0; g < n_cells; ++g)
+    this->cell_offset[g + 1] += this->cell_offset[g];
+
+  std::vector<size_t> cursor(this->cell_offset.begin(), this->cell_offset.end() - 1);
+  this->cell_tiles.resize(this->cell_offset.back());
+  for (size_t t = 0; t < this->tiles.size(); ++t)
+    overlap(this->tiles[t], [&](const size_t g) { this->cell_tiles[cursor[g]++] = t; });
+}
+
+//! Blocks of a Tile which Intersect the Window [wmin, wmax)
+inline std::pair<glm::ivec2, glm::ivec2> mosaic::range(const size_t t, const glm::ivec2 wmin, const glm::ivec2 wmax) const {
+  const tile_t &tile = this->tiles[t];
+  const glm::ivec2 imin = glm::max(wmin, tile.min);
+  const glm::ivec2 imax = glm::min(wmax, tile.min + tile.ext);
+  return {(imin - tile.min) / tile.block, (imax - tile.min - glm::ivec2(1)) / tile.block};
+}
+
+//! Cache Key of a Tile Block
+inline size_t mosaic::key(const size_t t, const glm::ivec2 b) const {
+  const tile_t &tile = this->tiles[t];
+  const glm::ivec2 blocks = (tile.ext + tile.block - glm::ivec2(1)) / tile.block;
+  return tile.key + size_t(b[0]) * blocks[1] + b[1];
+}
+
+//! Insert a Block into the Cache
+//!
+//! The least recently used blocks are evicted above the capacity,
+//! but the inserted block is always kept.
+inline void mosaic::insert(const size_t key, const soil::buffer &buffer) {
+
+  while (!this->lru.empty() && this->_bytes + mosaic::bytes(buffer) > this->_capacity) {
+    this->_bytes -= mosaic::bytes(this->lru.back().second);
+    this->lookup.erase(this->lru.back().first);
+    this->lru.pop_back();
+  }
+
+  this->lru.emplace_front(key, buffer);
+  this->lookup[key] = this->lru.begin();
+  this->_bytes += mosaic::bytes(buffer);
+}
+
+//! Load the Tile Blocks which Intersect a Window through the Cache
+//!
+//! Cached blocks are collected first, and the missing blocks are then
+//! decoded in a single parallel pass with the metadata of the tiles.
+//! Every block is a single strip or tile of the file, which is decoded
+//! with a windowed read of its extent. The blocks of a read are
+//! referenced, so that eviction can't drop them.
+inline void mosaic::load(const std::vector<size_t> &overlap, const glm::ivec2 wmin, const glm::ivec2 wmax, blocks_t &blocks) {
+
+  std::vector<miss_t> missing;
+  for (const size_t t : overlap) {
+    const auto [bmin, bmax] = this->range(t, wmin, wmax);
+    for (int bx = bmin[0]; bx <= bmax[0]; ++bx) {
+      for (int by = bmin[1]; by <= bmax[1]; ++by) {
+        const size_t key = this->key(t, glm::ivec2(bx, by));
+        const auto it = this->lookup.find(key);
+        if (it == this->lookup.end()) {
+          missing.push_back({t, glm::ivec2(bx, by), key});
+          continue;
+        }
+        this->lru.splice(this->lru.begin(), this->lru, it->second);
+        blocks.emplace(key, it->second->second);
+      }
+    }
+  }
+
+  // Decode the Missing Blocks in Parallel
+  //  Note: Workers claim blocks from a shared counter in tile
+  //  order, and keep the handle of their current tile open.
+
+  std::vector<soil::buffer> decoded(missing.size());
+  std::atomic<size_t> next{0};
+
+  auto &pool = soil::thread_pool::get();
+  pool.run(std::min(pool.size(), missing.size()), [&](const size_t) {
+    std::unique_ptr<TIFF, decltype(&TIFFClose)> handle(NULL, &TIFFClose);
+    size_t current = this->tiles.size();
+    for (size_t k = next++; k < missing.size(); k = next++) {
+      const tile_t &tile = this->tiles[missing[k].t];
+      if (missing[k].t != current) {
+        handle.reset(TIFFOpen(tile.filename.c_str(), "r"));
+        if (handle == NULL)
+          throw soil::error::missing_file(tile.filename);
+        current = missing[k].t;
+      }
+      decoded[k] = tile.header.decode(handle.get(), missing[k].b * tile.block, tile.block);
+    }
+  });
+
+  for (size_t k = 0; k < missing.size(); ++k) {
+    this->insert(missing[k].key, decoded[k]);
+    blocks.emplace(missing[k].key, decoded[k]);
+  }
+}
+
+//! Copy the Valid Values of a Tile into a Window
+template<typename T>
+void mosaic::blit(T *out, const glm::ivec2 wmin, const glm::ivec2 wext, const size_t t, const blocks_t &blocks) const {
+
+  const tile_t &tile = this->tiles[t];
+  const glm::ivec2 imin = glm::max(wmin, tile.min);
+  const glm::ivec2 imax = glm::min(wmin + wext, tile.min + tile.ext);
+  const auto [bmin, bmax] = this->range(t, wmin, wmin + wext);
+
+  for (int bx = bmin[0]; bx <= bmax[0]; ++bx) {
+    for (int by = bmin[1]; by <= bmax[1]; ++by) {
+
+      const soil::buffer &buffer = blocks.at(this->key(t, glm::ivec2(bx, by)));
+      const glm::ivec2 borg = tile.min + tile.block * glm::ivec2(bx, by);
+      const glm::ivec2 bext = glm::min(tile.block, tile.min + tile.ext - borg);
+
+      const glm::ivec2 cmin = glm::max(imin, borg);
+      const glm::ivec2 cmax = glm::min(imax, borg + bext);
+
+      soil::select(buffer.type(), [&]<typename S>() {
+        if constexpr (std::is_convertible_v<S, T>) {
+          const S *in = buffer.as<S>().data();
+          for (int r = cmin[0]; r < cmax[0]; ++r) {
+            T *o = out + size_t(r - wmin[0]) * wext[1] - wmin[1];
+            const S *i = in + size_t(r - borg[0]) * bext[1] - borg[1];
+            for (int c = cmin[1]; c < cmax[1]; ++c) {
+              if (o[c] != o[c] && double(i[c]) != tile.nodata)
+                o[c] = T(i[c]);
+            }
+          }
+        }
+      });
+    }
+  }
+}
+
+inline soil::io::geotiff mosaic::read(const glm::dvec2 min, const glm::dvec2 max) {
+
+  // World-Space Rectangle to Pixel Window (Row, Column)
+
+  const glm::ivec2 pmin(std::floor((this->_max[1] - max[1]) / this->_scale[1]), std::floor((min[0] - this->_min[0]) / this->_scale[0]));
+  const glm::ivec2 pmax(std::ceil((this->_max[1] - min[1]) / this->_scale[1]), std::ceil((max[0] - this->_min[0]) / this->_scale[0]));
+
+  const glm::ivec2 wmin = glm::clamp(pmin, glm::ivec2(0), this->_ext);
+  const glm::ivec2 wmax = glm::clamp(pmax, wmin, this->_ext);
+  const glm::ivec2 wext = wmax - wmin;
+
+  if (wext[0] <= 0 || wext[1] <= 0)
+    throw std::invalid_argument("window does not intersect the mosaic");
+
+  soil::index index(wext);
+  soil::buffer buffer(this->type, index.elem());
+
+  // Overlapping Tiles (in File Order)
+
+  std::vector<size_t> overlap;
+  const glm::ivec2 cmin = wmin / this->cell;
+  const glm::ivec2 cmax = (wmax - glm::ivec2(1)) / this->cell;
+  for (int x = cmin[0]; x <= cmax[0]; ++x) {
+    for (int y = cmin[1]; y <= cmax[1]; ++y) {
+      const size_t g = size_t(x) * this->grid[1] + y;
+      for (size_t i = this->cell_offset[g]; i < this->cell_offset[g + 1]; ++i) {
+        const tile_t &tile = this->tiles[this->cell_tiles[i]];
+        const glm::ivec2 tmax = tile.min + tile.ext;
+        if (tile.min[0] < wmax[0] && tile.min[1] < wmax[1] && wmin[0] < tmax[0] && wmin[1] < tmax[1])
+          overlap.push_back(this->cell_tiles[i]);
+      }
+    }
+  }
+  std::sort(overlap.begin(), overlap.end());
+  overlap.erase(std::unique(overlap.begin(), overlap.end()), overlap.end());
+
+  blocks_t blocks;
+  this->load(overlap, wmin, wmax, blocks);
+
+  soil::select(this->type, [&]<typename T>() {
+    if constexpr (std::is_floating_point_v<T>) {
+      auto buffer_t = buffer.as<T>();
+      std::fill(buffer_t.data(), buffer_t.data() + buffer_t.elem(), std::numeric_limits<T>::quiet_NaN());
+      for (const size_t t : overlap)
+        this->blit<T>(buffer_t.data(), wmin, wext, t, blocks);
+    }
+  });
+
+  // Georeferenced Window
+
+  soil::io::geotiff geotiff(buffer, index);
+  geotiff._meta = this->meta;
+  geotiff._meta.filename = "";
+  geotiff._meta.width = wext[1];
+  geotiff._meta.height = wext[0];
+  geotiff._meta.coords = {0.0, 0.0, 0.0, this->_min[0] + this->_scale[0] * wmin[1], this->_max[1] - this->_scale[1] * wmin[0], 0.0};
+  return geotiff;
+}
+
+} // end of namespace io
+} // end of namespace soil
+
+#endif
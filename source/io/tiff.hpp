@@ -3,22 +3,60 @@
 
 #include <soillib/core/buffer.hpp>
 #include <soillib/core/index.hpp>
+#include <soillib/op/pyramid.hpp>
+#include <soillib/util/thread.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
 #include <iostream>
-#include <stdfloat>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <tiffio.h>
+#include <utility>
+#include <vector>
 
 namespace soil {
 namespace io {
 
+//! TIFF Compression Scheme
+enum compress_t {
+  NONE,    //!< Uncompressed
+  LZW,     //!< Lempel-Ziv-Welch
+  DEFLATE, //!< Deflate (zlib)
+  ZSTD     //!< Zstandard (libtiff >= 4.0.10)
+};
+
 //! tiff is a generic .tiff file interface for reading
 //! and writing generic image data to and from disk.
 //!
-//! tiff supports multiple different bit-depths, as
-//! well as the reading of tiled .tiff images.
+//! tiff supports multiple different bit-depths and sample
+//! formats, which are read into a buffer of the matching type
+//! (8-bit unsigned, 16-bit signed, unsigned or floating-point,
+//! 32-bit signed or floating-point and 64-bit floating-point),
+//! as well as the reading of tiled .tiff images.
+//!
+//! Images can be written with a tiled layout, compression
+//! and the floating-point predictor, in which case the blocks
+//! are compressed in parallel on the host thread pool. Images
+//! larger than 4 GB are written as BigTIFF.
+//!
+//! Reduced-resolution overviews can be appended as additional
+//! directories, which are listed by peek and can be read directly.
 //!
 struct tiff {
 
+  //! TIFF Writer Options
+  struct options_t {
+    uint32_t tile = 0;          //!< Tile Extent (Multiple of 16, 0: Strips)
+    compress_t compress = NONE; //!< Compression Scheme
+    bool predictor = false;     //!< Predictor (Floating-Point or Horizontal)
+    bool bigtiff = false;       //!< Force BigTIFF (Automatic above 4 GB)
+    uint32_t overviews = 0;     //!< Number of Overview Levels
+  };
+
   tiff() {}
   tiff(const char *filename) { read(filename); };
 
@@ -28,26 +66,73 @@ struct tiff {
 
     this->_height = _index.as<flat_t<2>>()[0];
     this->_width = _index.as<flat_t<2>>()[1];
-
-    if (type == soil::FLOAT32) {
-      this->_bits = 32;
-    } else if (type == soil::FLOAT64) {
-      this->_bits = 64;
-    }
+    this->_bits = 8 * this->sample_bytes();
+    this->_format = soil::select(type, []<typename T>() -> uint16_t {
+      if constexpr (std::is_floating_point_v<T> || std::is_same_v<T, soil::half>) {
+        return SAMPLEFORMAT_IEEEFP;
+      } else if constexpr (std::is_signed_v<T>) {
+        return SAMPLEFORMAT_INT;
+      } else {
+        return SAMPLEFORMAT_UINT;
+      }
+    });
   }
 
   bool peek(const char *filename);  //!< Load TIFF Metadata
   bool read(const char *filename);  //!< Read TIFF Raw Data
+  bool read(const char *filename, const glm::ivec2 min, const glm::ivec2 ext); //!< Read TIFF Raw Data Window
+  bool read(const char *filename, const size_t level); //!< Read TIFF Overview Level
   bool write(const char *filename); //!< Write TIFF Raw Data
+  bool write(const char *filename, const options_t &options); //!< Write TIFF Raw Data w. Options
+
+  //! Decode a Window with an Open Handle (see below)
+  soil::buffer decode(TIFF *tif, const glm::ivec2 min, const glm::ivec2 ext) const;
 
   uint32_t bits() const { return this->_bits; }
   uint32_t width() const { return this->_width; }
   uint32_t height() const { return this->_height; }
 
+  //! Native Block Extent (Row, Column): Tile, or Strip of the Full Width
+  glm::ivec2 block() const {
+    if (this->tiled_image)
+      return glm::ivec2(this->_theight, this->_twidth);
+    return glm::ivec2(std::min<uint32_t>(this->_srows, this->_height), this->_width);
+  }
+
   soil::buffer buffer() const { return this->_buffer; }
   soil::index index() const { return this->_index; }
 
+  //! Extents (Row, Column) of the Overview Levels 1, 2, ...
+  std::vector<glm::ivec2> overviews() const { return this->_overviews; }
+
 protected:
+  bool peek_directory(TIFF *tif); //!< Load Metadata of Current Directory
+  bool read_directory(const char *filename, const uint16_t directory, const glm::ivec2 min, const glm::ivec2 ext);
+
+  //! Block Extent (Row, Column) and Bytes of the Current Directory
+  std::pair<glm::ivec2, size_t> layout(TIFF *tif) const;
+
+  //! Window [wmin, wmax) of the Image which Intersects [min, min + ext)
+  std::pair<glm::ivec2, glm::ivec2> window(const glm::ivec2 min, const glm::ivec2 ext) const;
+
+  //! Decode a Block and Copy its Intersection with a Window
+  template<typename T>
+  bool decode_block(TIFF *tif, const glm::ivec2 org, const glm::ivec2 block, std::vector<uint8_t> &nbuf, T *buf, const glm::ivec2 wmin, const glm::ivec2 wmax) const;
+  TIFF *open(const char *filename, const options_t &options) const; //!< Open TIFF for Writing
+  void write_fields(TIFF *out, const options_t &options) const;    //!< Write Image and Layout Tags
+  bool write_data(TIFF *out, const options_t &options);            //!< Write Raw Data Blocks
+  bool write_overviews(TIFF *out, const options_t &options, std::optional<double> nodata = std::nullopt); //!< Write Overview Directories
+
+  //! Buffer Type of the Sample Format and Bit-Depth
+  soil::dtype sample_type() const;
+
+  //! Bytes per Sample of the Buffer
+  size_t sample_bytes() const {
+    return soil::select(this->_buffer.type(), []<typename T>() -> size_t {
+      return sizeof(T);
+    });
+  }
+
   bool meta_loaded = false; //!< Flag: Is Meta-Data Loaded
   bool tiled_image = false; //!< Flag: Is Image Tiled
 
@@ -57,8 +142,14 @@ protected:
   uint32_t _height = 0; //!< Image Height
   uint32_t _bits = 0;   //!< Pixel Bit-Depth
 
+  uint16_t _format = SAMPLEFORMAT_IEEEFP; //!< Pixel Sample Format
+
   uint32_t _twidth = 0;  //!< Tile Width
   uint32_t _theight = 0; //!< Tile Height
+  uint32_t _srows = 0;   //!< Rows per Strip
+
+  std::vector<glm::ivec2> _overviews;   //!< Overview Extents
+  std::vector<uint16_t> _overview_dirs; //!< Overview Directories
 
   soil::index _index;   //!< Underlying Data Index
   soil::buffer _buffer; //!< Underlying Data Buffer
@@ -73,6 +164,42 @@ bool tiff::peek(const char *filename) {
     return false;
   }
 
+  if (!this->peek_directory(tif)) {
+    TIFFClose(tif);
+    return false;
+  }
+
+  // Overview Directories (Reduced Resolution)
+
+  this->_overviews.clear();
+  this->_overview_dirs.clear();
+
+  const uint16_t n_dirs = TIFFNumberOfDirectories(tif);
+  for (uint16_t dir = 1; dir < n_dirs; ++dir) {
+    if (!TIFFSetDirectory(tif, dir))
+      break;
+    uint32_t type = 0, width = 0, height = 0;
+    TIFFGetField(tif, TIFFTAG_SUBFILETYPE, &type);
+    if (!(type & FILETYPE_REDUCEDIMAGE))
+      continue;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+    this->_overviews.emplace_back(height, width);
+    this->_overview_dirs.push_back(dir);
+  }
+
+  TIFFClose(tif);
+
+  this->filename = filename;
+  this->meta_loaded = true;
+  return true;
+}
+
+//! Load Metadata of the Current Directory
+bool tiff::peek_directory(TIFF *tif) {
+
+  this->tiled_image = false;
+
   if (!TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &this->_width))
     return false;
 
@@ -82,160 +209,519 @@ bool tiff::peek(const char *filename) {
   if (!TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &this->_bits))
     return false;
 
+  // Note: Without the tag, the samples are unsigned integers by
+  //  the specification, but 32 and 64-bit images written without
+  //  it are assumed to be floating-point, as they were before.
+  if (!TIFFGetField(tif, TIFFTAG_SAMPLEFORMAT, &this->_format))
+    this->_format = (this->_bits >= 32) ? SAMPLEFORMAT_IEEEFP : SAMPLEFORMAT_UINT;
+
   if (TIFFGetField(tif, TIFFTAG_TILEWIDTH, &this->_twidth))
     this->tiled_image = true;
 
   if (TIFFGetField(tif, TIFFTAG_TILELENGTH, &this->_theight))
     this->tiled_image = true;
 
-  TIFFClose(tif);
+  TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &this->_srows);
 
-  this->filename = filename;
-  this->meta_loaded = true;
   return true;
 }
 
+//! Buffer Type of the Sample Format and Bit-Depth
+soil::dtype tiff::sample_type() const {
+
+  const uint16_t format = this->_format;
+  const uint32_t bits = this->_bits;
+
+  if (bits == 8 && format == SAMPLEFORMAT_UINT)
+    return soil::UINT8;
+  if (bits == 16 && format == SAMPLEFORMAT_UINT)
+    return soil::UINT16;
+  if (bits == 16 && format == SAMPLEFORMAT_INT)
+    return soil::INT16;
+  if (bits == 16 && format == SAMPLEFORMAT_IEEEFP)
+    return soil::FLOAT16;
+  if (bits == 32 && format == SAMPLEFORMAT_INT)
+    return soil::INT;
+  if (bits == 32 && format == SAMPLEFORMAT_IEEEFP)
+    return soil::FLOAT32;
+  if (bits == 64 && format == SAMPLEFORMAT_IEEEFP)
+    return soil::FLOAT64;
+
+  throw std::invalid_argument("unsupported tiff sample format (" + std::to_string(bits) + "-bit, format " + std::to_string(format) + ")");
+}
+
 //! Read TIFF Raw Data
 bool tiff::read(const char *filename) {
+  // Note: The window is clipped to the full image
+  return this->read(filename, glm::ivec2(0), glm::ivec2(INT_MAX));
+}
 
-  if (!meta_loaded) {
-    this->peek(filename);
-  }
+//! Read a Window of TIFF Raw Data
+//!
+//! Only the strips or tiles which intersect the window are decoded,
+//! in parallel on the host thread pool.
+//! The window is given in index coordinates (row, column), and is
+//! clipped to the image. Afterwards, the width and height refer to
+//! the window, which is stored in a compact buffer and flat index.
+bool tiff::read(const char *filename, const glm::ivec2 min, const glm::ivec2 ext) {
+  return this->read_directory(filename, 0, min, ext);
+}
 
-  // Note: TIFF is Column Major (See Reading Function Below)
-  //  Therefore,
+//! Read TIFF Overview Level
+//!
+//! Level 0 is the full resolution image, and levels 1, 2, ...
+//! are the overviews in the order listed by peek.
+bool tiff::read(const char *filename, const size_t level) {
 
-  this->_index = soil::index(soil::ivec2{(int)this->height(), (int)this->width()});
+  this->peek(filename);
+  if (level > this->_overviews.size())
+    throw std::out_of_range("overview level out of range");
 
-  if (this->bits() == 16) { // Note: Internal Type is still Float32
-    this->_buffer = soil::buffer(soil::FLOAT32, _index.elem());
-  }
-  if (this->bits() == 32) {
-    this->_buffer = soil::buffer(soil::FLOAT32, _index.elem());
-  }
-  if (this->bits() == 64) {
-    this->_buffer = soil::buffer(soil::FLOAT64, _index.elem());
+  const uint16_t directory = (level == 0) ? 0 : this->_overview_dirs[level - 1];
+  return this->read_directory(filename, directory, glm::ivec2(0), glm::ivec2(INT_MAX));
+}
+
+//! Read a Window of a TIFF Directory
+bool tiff::read_directory(const char *filename, const uint16_t directory, const glm::ivec2 min, const glm::ivec2 ext) {
+
+  // Note: Always re-load the metadata, since a previous
+  //  windowed read overwrites the width and height.
+  this->peek(filename);
+
+  if (directory != 0) {
+    TIFF *tif = TIFFOpen(filename, "r");
+    if (tif == NULL)
+      throw soil::error::missing_file(filename);
+    const bool loaded = TIFFSetDirectory(tif, directory) && this->peek_directory(tif);
+    TIFFClose(tif);
+    if (!loaded)
+      return false;
   }
 
+  // Note: TIFF is Row Major, therefore the window
+  //  is given as (row, column), like the flat index.
+
+  const std::pair<glm::ivec2, glm::ivec2> clip = this->window(min, ext);
+  const glm::ivec2 wmin = clip.first;
+  const glm::ivec2 wmax = clip.second;
+  const glm::ivec2 wext = wmax - wmin;
+
+  if (wext[0] <= 0 || wext[1] <= 0)
+    throw std::invalid_argument("window does not intersect the image");
+
   TIFF *tif = TIFFOpen(filename, "r");
   if (tif == NULL) {
     throw soil::error::missing_file(filename);
     return false;
   }
+  TIFFSetDirectory(tif, directory);
+  const std::pair<glm::ivec2, size_t> shape = this->layout(tif);
+  const glm::ivec2 block = shape.first;
+  const size_t block_size = shape.second;
+  TIFFClose(tif);
 
-  // Load Tiled / Non-Tiled Images
-  if (!this->tiled_image) {
+  this->_index = soil::index(wext);
+  this->_buffer = soil::buffer(this->sample_type(), _index.elem());
+
+  this->_height = wext[0];
+  this->_width = wext[1];
+
+  // Origins of the Blocks which Intersect the Window
+
+  std::vector<glm::ivec2> blocks;
+  for (int by = wmin[0] - wmin[0] % block[0]; by < wmax[0]; by += block[0])
+    for (int bx = wmin[1] - wmin[1] % block[1]; bx < wmax[1]; bx += block[1])
+      blocks.emplace_back(by, bx);
+
+  // Decode the Blocks in Parallel
+  //  Note: libtiff handles are not thread-safe, so every
+  //  worker opens its own handle and claims blocks from
+  //  a shared counter. The blocks don't overlap, so the
+  //  result does not depend on the order of decoding.
+  //  A block which fails to decode stops all workers,
+  //  since the buffer would be left partially undefined.
+
+  std::atomic<bool> failed{false};
+
+  soil::select(this->_buffer.type(), [&]<typename T>() {
+    T *buf = (T *)this->_buffer.data();
+    std::atomic<size_t> next{0};
+
+    auto &pool = soil::thread_pool::get();
+    pool.run(std::min(pool.size(), blocks.size()), [&](const size_t) {
+      std::unique_ptr<TIFF, decltype(&TIFFClose)> handle(TIFFOpen(filename, "r"), &TIFFClose);
+      if (handle == NULL)
+        throw soil::error::missing_file(filename);
+      TIFFSetDirectory(handle.get(), directory);
+
+      std::vector<uint8_t> nbuf(block_size);
+      for (size_t k = next++; k < blocks.size() && !failed; k = next++) {
+        if (!this->decode_block<T>(handle.get(), blocks[k], block, nbuf, buf, wmin, wmax)) {
+          failed = true;
+          break;
+        }
+      }
+    });
+  });
 
-    auto data = this->_buffer.data();
-    uint8_t *buf = (uint8_t *)data;
+  if (failed) {
+    this->_buffer = soil::buffer();
+    throw std::runtime_error(std::string("failed to decode tiff ") + filename);
+  }
 
-    uint8_t *nbuf = new uint8_t[this->width() * (this->bits() / 8)];
+  return true;
+}
 
-    for (size_t row = 0; row < this->height(); row++) {
-      TIFFReadScanline(tif, nbuf, row);
+//! Decode a Window with an Open Handle
+//!
+//! The metadata of the current directory of the handle has to be
+//! loaded (peek) and is not modified, so that a loaded tiff can
+//! decode windows concurrently, each with its own handle. The
+//! window is clipped to the image and decoded sequentially.
+soil::buffer tiff::decode(TIFF *tif, const glm::ivec2 min, const glm::ivec2 ext) const {
+
+  const std::pair<glm::ivec2, glm::ivec2> clip = this->window(min, ext);
+  const glm::ivec2 wmin = clip.first;
+  const glm::ivec2 wmax = clip.second;
+  const glm::ivec2 wext = wmax - wmin;
+
+  if (wext[0] <= 0 || wext[1] <= 0)
+    throw std::invalid_argument("window does not intersect the image");
+
+  const std::pair<glm::ivec2, size_t> shape = this->layout(tif);
+  const glm::ivec2 block = shape.first;
+  const size_t block_size = shape.second;
+  soil::buffer buffer(this->sample_type(), size_t(wext[0]) * size_t(wext[1]));
+
+  const bool decoded = soil::select(buffer.type(), [&]<typename T>() -> bool {
+    T *buf = (T *)buffer.data();
+    std::vector<uint8_t> nbuf(block_size);
+    for (int by = wmin[0] - wmin[0] % block[0]; by < wmax[0]; by += block[0])
+      for (int bx = wmin[1] - wmin[1] % block[1]; bx < wmax[1]; bx += block[1])
+        if (!this->decode_block<T>(tif, glm::ivec2(by, bx), block, nbuf, buf, wmin, wmax))
+          return false;
+    return true;
+  });
+
+  if (!decoded)
+    throw std::runtime_error("failed to decode tiff " + this->filename);
+
+  return buffer;
+}
 
-      for (size_t i = 0; i < this->width(); ++i) {
+//! Block Layout: Strips are Blocks of the Full Width
+std::pair<glm::ivec2, size_t> tiff::layout(TIFF *tif) const {
+  if (this->tiled_image)
+    return {this->block(), size_t(TIFFTileSize(tif))};
+  return {this->block(), size_t(TIFFStripSize(tif))};
+}
 
-        if (this->bits() == 16) {
-          ((float *)buf)[i] = ((std::float16_t *)nbuf)[i];
-        }
-        if (this->bits() == 32) {
-          ((float *)buf)[i] = ((float *)nbuf)[i];
-        }
-        if (this->bits() == 64) {
-          ((double *)buf)[i] = ((double *)nbuf)[i];
-        }
-      }
+//! Window Clipped to the Image
+//!
+//! The end of the window is computed in 64-bit, since min + ext
+//! overflows for large extents (e.g. to read until the image end).
+std::pair<glm::ivec2, glm::ivec2> tiff::window(const glm::ivec2 min, const glm::ivec2 ext) const {
+  const int64_t image[2] = {this->height(), this->width()};
+  glm::ivec2 wmin, wmax;
+  for (int i = 0; i < 2; ++i) {
+    wmin[i] = std::clamp<int64_t>(min[i], 0, image[i]);
+    wmax[i] = std::clamp<int64_t>(int64_t(min[i]) + ext[i], wmin[i], image[i]);
+  }
+  return {wmin, wmax};
+}
 
-      if (this->bits() == 16) {
-        buf += this->width() * (32 / 8);
-      }
-      if (this->bits() == 32) {
-        buf += this->width() * (32 / 8);
-      }
-      if (this->bits() == 64) {
-        buf += this->width() * (64 / 8);
-      }
-    }
+//! Decode the Block at Origin org and Copy the Rows which
+//! Intersect the Window [wmin, wmax) into the Compact Buffer
+template<typename T>
+bool tiff::decode_block(TIFF *tif, const glm::ivec2 org, const glm::ivec2 block, std::vector<uint8_t> &nbuf, T *buf, const glm::ivec2 wmin, const glm::ivec2 wmax) const {
+
+  if (this->tiled_image) {
+    const ttile_t tile = TIFFComputeTile(tif, org[1], org[0], 0, 0);
+    if (TIFFReadEncodedTile(tif, tile, nbuf.data(), nbuf.size()) < 0)
+      return false;
+  } else {
+    const tstrip_t strip = TIFFComputeStrip(tif, org[0], 0);
+    if (TIFFReadEncodedStrip(tif, strip, nbuf.data(), nbuf.size()) < 0)
+      return false;
+  }
 
-    delete[] nbuf;
+  const T *src = (const T *)nbuf.data();
+  const glm::ivec2 bmin = glm::max(org, wmin);
+  const glm::ivec2 bmax = glm::min(org + block, wmax);
+  const size_t n = bmax[1] - bmin[1];
+  const size_t wext = wmax[1] - wmin[1];
+
+  for (int r = bmin[0]; r < bmax[0]; ++r) {
+    T *out = buf + size_t(r - wmin[0]) * wext + (bmin[1] - wmin[1]);
+    const T *in = src + size_t(r - org[0]) * block[1] + (bmin[1] - org[1]);
+    std::memcpy(out, in, n * sizeof(T));
   }
 
-  else {
+  return true;
+}
 
-    const size_t tsize = this->_twidth * this->_theight;
-    const size_t nwidth = (this->width() + this->_twidth - 1) / this->_twidth;
-    const size_t nheight = (this->height() + this->_theight - 1) / this->_theight;
+namespace {
 
-    auto data = this->_buffer.data();
-    uint8_t *buf = (uint8_t *)data;
+//! tiff_stream is an in-memory TIFF file, which is used to
+//! encode single blocks with libtiff off the output file, so
+//! that the blocks can be compressed concurrently.
+struct tiff_stream {
 
-    uint8_t *nbuf = new uint8_t[tsize * (this->bits() / 8)];
+  std::vector<uint8_t> data;
+  size_t pos = 0;
 
-    for (size_t nx = 0; nx < nwidth; ++nx)
-      for (size_t ny = 0; ny < nheight; ++ny) {
+  TIFF *open(const char *mode) {
+    this->pos = 0;
+    return TIFFClientOpen("memory", mode, (thandle_t)this, read, write, seek, close, size, map, unmap);
+  }
 
-        const glm::ivec2 npos(nx, ny);
-        const glm::ivec2 norg = npos * glm::ivec2(this->_twidth, this->_theight);
+private:
+  static tmsize_t read(thandle_t handle, void *buf, tmsize_t n) {
+    tiff_stream &s = *(tiff_stream *)handle;
+    n = std::min<tmsize_t>(n, s.data.size() - std::min(s.pos, s.data.size()));
+    std::memcpy(buf, s.data.data() + s.pos, n);
+    s.pos += n;
+    return n;
+  }
 
-        if (!TIFFReadTile(tif, nbuf, norg.x, norg.y, 0, 0)) {
-          continue;
-        }
+  static tmsize_t write(thandle_t handle, void *buf, tmsize_t n) {
+    tiff_stream &s = *(tiff_stream *)handle;
+    if (s.pos + n > s.data.size())
+      s.data.resize(s.pos + n);
+    std::memcpy(s.data.data() + s.pos, buf, n);
+    s.pos += n;
+    return n;
+  }
 
-        for (size_t ix = 0; ix < this->_twidth; ix++)
-          for (size_t iy = 0; iy < this->_theight; iy++) {
-
-            glm::ivec2 tpos = glm::ivec2(ix, iy);
-            glm::ivec2 fpos = norg + tpos;
-
-            if (fpos.x >= this->width())
-              continue;
-            if (fpos.y >= this->height())
-              continue;
-
-            if (this->bits() == 16) {
-              ((float *)buf)[fpos.y * this->width() + fpos.x] = ((std::float16_t *)nbuf)[iy * this->_twidth + ix];
-            }
-            if (this->bits() == 32) {
-              ((float *)buf)[fpos.y * this->width() + fpos.x] = ((float *)nbuf)[iy * this->_twidth + ix];
-            }
-            if (this->bits() == 64) {
-              ((double *)buf)[fpos.y * this->width() + fpos.x] = ((double *)nbuf)[iy * this->_twidth + ix];
-            }
-          }
-      }
+  static toff_t seek(thandle_t handle, toff_t off, int whence) {
+    tiff_stream &s = *(tiff_stream *)handle;
+    if (whence == SEEK_SET)
+      s.pos = off;
+    if (whence == SEEK_CUR)
+      s.pos += off;
+    if (whence == SEEK_END)
+      s.pos = s.data.size() + off;
+    return s.pos;
+  }
+
+  static toff_t size(thandle_t handle) { return ((tiff_stream *)handle)->data.size(); }
+  static int close(thandle_t) { return 0; }
+  static int map(thandle_t, void **, toff_t *) { return 0; }
+  static void unmap(thandle_t, void *, toff_t) {}
+};
+
+} // namespace
 
-    delete[] nbuf;
+//! Write TIFF Raw Data
+bool tiff::write(const char *filename) {
+  return this->write(filename, options_t{});
+}
+
+//! Write TIFF Raw Data w. Options
+bool tiff::write(const char *filename, const options_t &options) {
+
+  TIFF *out = this->open(filename, options);
+
+  bool result = false;
+  try {
+    this->write_fields(out, options);
+    result = this->write_data(out, options) && this->write_overviews(out, options);
+  } catch (...) {
+    TIFFClose(out);
+    throw;
   }
 
-  TIFFClose(tif);
-  return true;
+  TIFFClose(out);
+  return result;
 }
 
-bool tiff::write(const char *filename) {
+//! Open TIFF for Writing
+//!
+//! Images whose raw data doesn't fit the 32-bit offsets of
+//! classic TIFF (incl. headroom for tags) are written as BigTIFF.
+TIFF *tiff::open(const char *filename, const options_t &options) const {
+
+  if (options.tile % 16 != 0)
+    throw std::invalid_argument("tile extent must be a multiple of 16");
+
+  // Note: Overviews add at most a third of the raw data
+  uint64_t bytes = uint64_t(this->_buffer.elem()) * this->sample_bytes();
+  if (options.overviews > 0)
+    bytes += bytes / 3;
+  const bool bigtiff = options.bigtiff || bytes > UINT32_MAX - (uint64_t(1) << 24);
+
+  TIFF *out = TIFFOpen(filename, bigtiff ? "w8" : "w");
+  if (out == NULL)
+    throw soil::error::missing_file(filename);
+  return out;
+}
 
-  TIFF *out = TIFFOpen(filename, "w");
+//! Write Image and Layout Tags
+void tiff::write_fields(TIFF *out, const options_t &options) const {
+
+  // Note: The Sample Bit-Depth and Format are those of the Buffer
+  const uint32_t bits = 8 * this->sample_bytes();
+  const bool floating = (this->_format == SAMPLEFORMAT_IEEEFP);
 
   TIFFSetField(out, TIFFTAG_IMAGEWIDTH, this->width());
   TIFFSetField(out, TIFFTAG_IMAGELENGTH, this->height());
   TIFFSetField(out, TIFFTAG_SAMPLESPERPIXEL, 1);
-  TIFFSetField(out, TIFFTAG_BITSPERSAMPLE, this->bits());
+  TIFFSetField(out, TIFFTAG_BITSPERSAMPLE, bits);
   TIFFSetField(out, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
   TIFFSetField(out, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
   TIFFSetField(out, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-  TIFFSetField(out, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
-  TIFFSetField(out, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(out, this->width()));
+  TIFFSetField(out, TIFFTAG_SAMPLEFORMAT, this->_format);
+
+  if (options.compress != NONE) {
+    const uint16_t codec = (options.compress == LZW)       ? COMPRESSION_LZW
+                           : (options.compress == DEFLATE) ? COMPRESSION_ADOBE_DEFLATE
+                                                           : COMPRESSION_ZSTD;
+    if (!TIFFIsCODECConfigured(codec))
+      throw std::invalid_argument("compression scheme is not configured in libtiff");
+    TIFFSetField(out, TIFFTAG_COMPRESSION, codec);
+  }
+  if (options.compress != NONE && options.predictor)
+    TIFFSetField(out, TIFFTAG_PREDICTOR, floating ? PREDICTOR_FLOATINGPOINT : PREDICTOR_HORIZONTAL);
+
+  if (options.tile > 0) {
+    TIFFSetField(out, TIFFTAG_TILEWIDTH, options.tile);
+    TIFFSetField(out, TIFFTAG_TILELENGTH, options.tile);
+  } else if (options.compress == NONE) {
+    TIFFSetField(out, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(out, this->width()));
+  } else {
+    // Note: Compressed Strips of ~256 kB, to amortize the Encoder Setup
+    const uint32_t row = std::max<uint32_t>(1, this->width() * bits / 8);
+    TIFFSetField(out, TIFFTAG_ROWSPERSTRIP, std::max<uint32_t>(1, (1 << 18) / row));
+  }
+}
 
-  auto data = this->_buffer.data();
-  uint8_t *buf = (uint8_t *)data;
+//! Write Raw Data Blocks
+//!
+//! The strips or tiles are encoded in batches on the host thread
+//! pool. Every block is copied out of the buffer (padded for edge
+//! tiles), and compressed by libtiff into an in-memory TIFF, from
+//! which the raw bytes are read back. The blocks are then appended
+//! to the output in order, so the file doesn't depend on the pool.
+bool tiff::write_data(TIFF *out, const options_t &options) {
+
+  const size_t bytes = this->sample_bytes();
+  const glm::ivec2 image(this->height(), this->width());
+
+  uint32_t strip_rows = 0;
+  TIFFGetFieldDefaulted(out, TIFFTAG_ROWSPERSTRIP, &strip_rows);
+
+  const bool tiled = (options.tile > 0);
+  const glm::ivec2 block = tiled ? glm::ivec2(options.tile) : glm::ivec2(std::min<uint32_t>(strip_rows, image[0]), image[1]);
+  const glm::ivec2 blocks = (image + block - glm::ivec2(1)) / block;
+  const size_t n_blocks = size_t(blocks[0]) * size_t(blocks[1]);
+
+  const uint8_t *buf = (const uint8_t *)this->_buffer.data();
+
+  // Encode a Single Block into its Raw Bytes
+  const auto encode = [&](const size_t k, std::vector<uint8_t> &raw) {
+    const glm::ivec2 org = block * glm::ivec2(k / blocks[1], k % blocks[1]);
+    const glm::ivec2 ext = tiled ? block : glm::min(block, image - org);
+    const glm::ivec2 cpy = glm::min(block, image - org);
+
+    std::vector<uint8_t> data(size_t(ext[0]) * ext[1] * bytes, 0);
+    for (int r = 0; r < cpy[0]; ++r) {
+      const uint8_t *in = buf + (size_t(org[0] + r) * image[1] + org[1]) * bytes;
+      std::memcpy(data.data() + size_t(r) * ext[1] * bytes, in, cpy[1] * bytes);
+    }
 
-  for (uint32_t row = 0; row < this->height(); row++) {
-    if (TIFFWriteScanline(out, buf, row, 0) < 0)
-      break;
-    buf += this->width() * (this->bits() / 8);
+    if (options.compress == NONE) {
+      raw = std::move(data);
+      return;
+    }
+
+    tiff_stream stream;
+    TIFF *tmp = stream.open("w");
+    if (tmp == NULL)
+      throw std::runtime_error("failed to open in-memory tiff");
+
+    TIFFSetField(tmp, TIFFTAG_IMAGEWIDTH, ext[1]);
+    TIFFSetField(tmp, TIFFTAG_IMAGELENGTH, ext[0]);
+    this->write_fields(tmp, options);
+    TIFFSetField(tmp, TIFFTAG_IMAGEWIDTH, ext[1]);
+    TIFFSetField(tmp, TIFFTAG_IMAGELENGTH, ext[0]);
+    if (!tiled)
+      TIFFSetField(tmp, TIFFTAG_ROWSPERSTRIP, ext[0]);
+
+    const tmsize_t encoded = tiled ? TIFFWriteEncodedTile(tmp, 0, data.data(), data.size())
+                                   : TIFFWriteEncodedStrip(tmp, 0, data.data(), data.size());
+    TIFFClose(tmp);
+    if (encoded < 0)
+      throw std::runtime_error("failed to encode tiff block");
+
+    tmp = stream.open("r");
+    if (tmp == NULL)
+      throw std::runtime_error("failed to read in-memory tiff");
+
+    uint64_t *counts = NULL;
+    if (!TIFFGetField(tmp, tiled ? TIFFTAG_TILEBYTECOUNTS : TIFFTAG_STRIPBYTECOUNTS, &counts) || counts == NULL) {
+      TIFFClose(tmp);
+      throw std::runtime_error("failed to read in-memory tiff block size");
+    }
+
+    raw.resize(counts[0]);
+    const tmsize_t read = tiled ? TIFFReadRawTile(tmp, 0, raw.data(), raw.size())
+                                : TIFFReadRawStrip(tmp, 0, raw.data(), raw.size());
+    TIFFClose(tmp);
+    if (read < 0 || size_t(read) != raw.size())
+      throw std::runtime_error("failed to read in-memory tiff block");
+  };
+
+  // Encode Batches in Parallel, Append in Order
+
+  const size_t batch = 4 * soil::thread_pool::get().size();
+  std::vector<std::vector<uint8_t>> raw(batch);
+
+  for (size_t start = 0; start < n_blocks; start += batch) {
+    const size_t stop = std::min(n_blocks, start + batch);
+
+    soil::parallel_for(stop - start, [&](const size_t i) {
+      encode(start + i, raw[i]);
+    }, 1);
+
+    for (size_t k = start; k < stop; ++k) {
+      std::vector<uint8_t> &data = raw[k - start];
+      const tmsize_t written = tiled ? TIFFWriteRawTile(out, k, data.data(), data.size())
+                                     : TIFFWriteRawStrip(out, k, data.data(), data.size());
+      if (written < 0)
+        return false;
+      data = std::vector<uint8_t>();
+    }
+  }
+
+  return true;
+}
+
+//! Write Overview Directories
+//!
+//! The overviews are the levels of a resolution pyramid over the
+//! image, computed by parallel, NaN-aware area averaging, which also
+//! excludes the nodata value if one is passed. Each level is appended
+//! as a reduced-resolution directory with the same layout and
+//! compression as the image, following the main directory.
+bool tiff::write_overviews(TIFF *out, const options_t &options, std::optional<double> nodata) {
+
+  if (options.overviews == 0)
+    return true;
+
+  soil::pyramid pyramid(this->_buffer, soil::index(glm::ivec2(this->height(), this->width())), options.overviews + 1, nodata);
+
+  for (size_t l = 1; l < pyramid.levels(); ++l) {
+
+    if (!TIFFWriteDirectory(out))
+      return false;
+
+    soil::io::tiff level(pyramid.level(l), soil::index(pyramid.index(l).ext()));
+    level.write_fields(out, options);
+    TIFFSetField(out, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+    if (!level.write_data(out, options))
+      return false;
   }
 
-  TIFFClose(out);
   return true;
 }
 
@@ -35,6 +35,10 @@ template void set_impl<vec2>  (soil::buffer_t<vec2> buffer,   const vec2 val, si
 template void set_impl<vec3>  (soil::buffer_t<vec3> buffer,   const vec3 val, size_t start, size_t stop, size_t step);
 template void set_impl<ivec2> (soil::buffer_t<ivec2> buffer,  const ivec2 val, size_t start, size_t stop, size_t step);
 template void set_impl<ivec3> (soil::buffer_t<ivec3> buffer,  const ivec3 val, size_t start, size_t stop, size_t step);
+template void set_impl<uint8_t>  (soil::buffer_t<uint8_t> buffer,  const uint8_t val, size_t start, size_t stop, size_t step);
+template void set_impl<int16_t>  (soil::buffer_t<int16_t> buffer,  const int16_t val, size_t start, size_t stop, size_t step);
+template void set_impl<uint16_t> (soil::buffer_t<uint16_t> buffer, const uint16_t val, size_t start, size_t stop, size_t step);
+template void set_impl<half>     (soil::buffer_t<half> buffer,     const half val, size_t start, size_t stop, size_t step);
 
 template<typename T>
 __global__ void _set(soil::buffer_t<T> lhs, const soil::buffer_t<T> rhs){
@@ -58,6 +62,10 @@ template void set_impl<vec2>  (soil::buffer_t<vec2> lhs,    const soil::buffer_t
 template void set_impl<vec3>  (soil::buffer_t<vec3> lhs,    const soil::buffer_t<vec3> rhs);
 template void set_impl<ivec2> (soil::buffer_t<ivec2> lhs,   const soil::buffer_t<ivec2> rhs);
 template void set_impl<ivec3> (soil::buffer_t<ivec3> lhs,   const soil::buffer_t<ivec3> rhs);
+template void set_impl<uint8_t>  (soil::buffer_t<uint8_t> lhs,  const soil::buffer_t<uint8_t> rhs);
+template void set_impl<int16_t>  (soil::buffer_t<int16_t> lhs,  const soil::buffer_t<int16_t> rhs);
+template void set_impl<uint16_t> (soil::buffer_t<uint16_t> lhs, const soil::buffer_t<uint16_t> rhs);
+template void set_impl<half>     (soil::buffer_t<half> lhs,     const soil::buffer_t<half> rhs);
 
 //
 // Resizing Kernels
@@ -119,6 +127,10 @@ template void resize_impl<vec2>  (soil::buffer_t<vec2> lhs,    const soil::buffe
 template void resize_impl<vec3>  (soil::buffer_t<vec3> lhs,    const soil::buffer_t<vec3> rhs,    soil::ivec2 out, soil::ivec2 in);
 template void resize_impl<ivec2> (soil::buffer_t<ivec2> lhs,   const soil::buffer_t<ivec2> rhs,   soil::ivec2 out, soil::ivec2 in);
 template void resize_impl<ivec3> (soil::buffer_t<ivec3> lhs,   const soil::buffer_t<ivec3> rhs,   soil::ivec2 out, soil::ivec2 in);
+template void resize_impl<uint8_t>  (soil::buffer_t<uint8_t> lhs,  const soil::buffer_t<uint8_t> rhs,   soil::ivec2 out, soil::ivec2 in);
+template void resize_impl<int16_t>  (soil::buffer_t<int16_t> lhs,  const soil::buffer_t<int16_t> rhs,   soil::ivec2 out, soil::ivec2 in);
+template void resize_impl<uint16_t> (soil::buffer_t<uint16_t> lhs, const soil::buffer_t<uint16_t> rhs,   soil::ivec2 out, soil::ivec2 in);
+template void resize_impl<half>     (soil::buffer_t<half> lhs,     const soil::buffer_t<half> rhs,   soil::ivec2 out, soil::ivec2 in);
 
 } // end of namespace soil
 
@@ -1,10 +1,18 @@
 #ifndef SOILLIB_OP_COMMON
 #define SOILLIB_OP_COMMON
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
+#include <stdexcept>
+#include <vector>
 #include <soillib/core/buffer.hpp>
 #include <soillib/core/index.hpp>
 #include <soillib/core/types.hpp>
+#include <soillib/util/thread.hpp>
 
 namespace soil {
 
@@ -12,6 +20,71 @@ inline int block(const int elem, const int thread) {
   return (elem + thread - 1) / thread;
 }
 
+//
+// Host Kernels
+//  Element-wise operations on the CPU are split into fixed-size
+//  chunks, which are executed on the host thread pool. Vector types
+//  are processed as flat arrays of their scalar components.
+//
+//  Within a chunk, components are processed in fixed-size blocks
+//  of one cache line, which are loaded into a local array before
+//  they are stored. This makes the blocks independent of aliasing,
+//  so that they are vectorized at the width of the target ISA
+//  (SSE / AVX2 / AVX-512), with a scalar loop for the remainder.
+//
+
+//! Number of Elements per Host Chunk (fits in the L2 Cache)
+constexpr size_t host_chunk = 1 << 15;
+
+//! Number of Scalar Components per Block (64 Bytes, or a Multiple of N)
+template<typename V, size_t N>
+constexpr size_t host_block = N * (64 / sizeof(V));
+
+//! Apply out[i] = func(out[i], in[i]) to the Scalar Components of two Buffers
+template<typename T, typename F>
+void host_binary(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs, F func) {
+  using V = typename soil::typedesc<T>::value_t;
+  constexpr size_t N = sizeof(T) / sizeof(V);
+  constexpr size_t B = host_block<V, 1>;
+  V *out = reinterpret_cast<V *>(lhs.data());
+  const V *in = reinterpret_cast<const V *>(rhs.data());
+  soil::parallel_chunk(lhs.elem(), host_chunk, [=](const size_t, const size_t start, const size_t stop) {
+    size_t i = N * start;
+    for (; i + B <= N * stop; i += B) {
+      V block[B];
+      for (size_t b = 0; b < B; ++b)
+        block[b] = func(out[i + b], in[i + b]);
+      for (size_t b = 0; b < B; ++b)
+        out[i + b] = block[b];
+    }
+    for (; i < N * stop; ++i)
+      out[i] = func(out[i], in[i]);
+  });
+}
+
+//! Apply out[i] = func(out[i], val) to the Scalar Components of a Buffer
+template<typename T, typename F>
+void host_unary(soil::buffer_t<T> &lhs, const T val, F func) {
+  using V = typename soil::typedesc<T>::value_t;
+  constexpr size_t N = sizeof(T) / sizeof(V);
+  constexpr size_t B = host_block<V, N>;
+  V value[B]; // Value Repeated over a Block
+  for (size_t b = 0; b < B; b += N)
+    std::memcpy(value + b, &val, sizeof(T));
+  V *out = reinterpret_cast<V *>(lhs.data());
+  soil::parallel_chunk(lhs.elem(), host_chunk, [=, &value](const size_t, const size_t start, const size_t stop) {
+    V v[B]; // Local Copy: can't alias the Output
+    std::memcpy(v, value, sizeof(v));
+    size_t i = N * start;
+    for (; i + B <= N * stop; i += B) {
+      for (size_t b = 0; b < B; ++b)
+        out[i + b] = func(out[i + b], v[b]);
+    }
+    for (size_t b = 0; i < N * stop; ++i, ++b)
+      out[i] = func(out[i], v[b]);
+  });
+}
+
 //
 // Casting
 //
@@ -43,8 +116,12 @@ template<typename T>
 void set(soil::buffer_t<T> buffer, const T val, size_t start, size_t stop, size_t step) {
 
   if (buffer.host() == soil::host_t::CPU) {
-    for (int i = start; i < stop; i += step)
-      buffer[i] = val;
+    if (step == 1 && start == 0 && stop == buffer.elem()) {
+      host_unary(buffer, val, [](auto, const auto b) { return b; });
+    } else {
+      for (size_t i = start; i < stop; i += step)
+        buffer[i] = val;
+    }
   }
 
   else if (buffer.host() == soil::host_t::GPU) {
@@ -70,8 +147,11 @@ void set(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs) {
     throw soil::error::mismatch_host(lhs.host(), rhs.host());
 
   if (lhs.host() == soil::host_t::CPU) {
-    for (size_t i = 0; i < lhs.elem(); ++i)
-      lhs[i] = rhs[i];
+    T *out = lhs.data();
+    const T *in = rhs.data();
+    soil::parallel_chunk(lhs.elem(), host_chunk, [=](const size_t, const size_t start, const size_t stop) {
+      std::memcpy(out + start, in + start, (stop - start) * sizeof(T));
+    });
   }
 
   else if (lhs.host() == soil::host_t::GPU) {
@@ -81,13 +161,279 @@ void set(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs) {
 
 //
 // Resize Operation
-//  Note: Currently only Bilinear Interpolation
+//
+
+//! Resampling Filter of soil::resize
+enum resize_t {
+  BILINEAR, //!< Linear Interpolation (Corner-Aligned)
+  BICUBIC,  //!< Cubic Convolution, a = -0.5 (Corner-Aligned)
+  AREA      //!< Box Filter over the Covered Input Area
+};
+
+namespace {
+
+//! resize_taps is a precomputed 1D weight table, which maps
+//! every output coordinate to a range of input taps.
+struct resize_taps {
+  std::vector<int> offset; //!< Tap Range of Output j: [offset[j], offset[j+1])
+  std::vector<int> index;  //!< Input Coordinate of Tap
+  std::vector<double> weight;
+};
+
+inline double resize_cubic(double x) {
+  constexpr double a = -0.5;
+  x = std::abs(x);
+  if (x < 1.0)
+    return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+  if (x < 2.0)
+    return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+  return 0.0;
+}
+
+inline resize_taps resize_table(const int out, const int in, const resize_t filter) {
+
+  resize_taps taps;
+  taps.offset.push_back(0);
+
+  const auto push = [&taps, in](const int i, const double w) {
+    taps.index.push_back(std::clamp(i, 0, in - 1));
+    taps.weight.push_back(w);
+  };
+
+  for (int j = 0; j < out; ++j) {
+
+    if (filter == AREA) {
+      const double scale = double(in) / double(out);
+      const double lo = j * scale;
+      const double hi = (j + 1) * scale;
+      for (int i = int(lo); i < std::min(in, int(std::ceil(hi))); ++i) {
+        const double w = std::min(hi, i + 1.0) - std::max(lo, double(i));
+        if (w > 0.0)
+          push(i, w / scale);
+      }
+    }
+
+    else {
+      // Corner-Aligned Source Coordinate, matching the GPU Kernel
+      const double x = (out > 1) ? j * double(in - 1) / double(out - 1) : 0.0;
+      const int i = int(std::floor(x));
+      const double f = x - i;
+      if (filter == BILINEAR) {
+        push(i, 1.0 - f);
+        push(i + 1, f);
+      } else {
+        for (int k = -1; k <= 2; ++k)
+          push(i + k, resize_cubic(f - k));
+      }
+    }
+
+    taps.offset.push_back(taps.index.size());
+  }
+
+  return taps;
+}
+
+//! Bytes of Pass 1 Intermediate per Band of the Host Resize
+constexpr size_t resize_band = 1 << 26;
+
+//! Pass 1 Intermediate Type of the Host Resize: float,
+//! unless it doesn't represent every value of V exactly.
+template<typename V>
+using resize_sum_t = std::conditional_t<(sizeof(V) <= 2 || std::is_same_v<V, float>), float, double>;
+
+//! Normalized Value of a Weighted Sum, Rounded and Saturated for Integers
+template<typename V>
+V resize_value(const double s, const double c) {
+  if (!(c > 1E-6))
+    return std::numeric_limits<V>::quiet_NaN();
+  const double v = s / c;
+  if constexpr (std::is_integral_v<V>) {
+    const double r = std::round(v);
+    constexpr V lo = std::numeric_limits<V>::lowest();
+    constexpr V hi = std::numeric_limits<V>::max();
+    return (r <= double(lo)) ? lo : (r >= double(hi)) ? hi : V(r);
+  } else {
+    return V(v);
+  }
+}
+
+//! Sum of the Tap Weights of every Output Coordinate
+inline std::vector<double> resize_weights(const resize_taps &taps) {
+  std::vector<double> w(taps.offset.size() - 1, 0.0);
+  for (size_t j = 0; j < w.size(); ++j)
+    for (int t = taps.offset[j]; t < taps.offset[j + 1]; ++t)
+      w[j] += taps.weight[t];
+  return w;
+}
+
+} // namespace
+
+//! Host Resize: Separable Two-Pass Filter over Weight Tables
+//!
+//! Every scalar component is filtered independently. NaN values are
+//! excluded from the weighted sum, and the result is normalized by
+//! the sum of the remaining weights, so that nodata regions don't
+//! bleed into valid ones. Outputs without valid inputs are NaN.
+//!
+//! Since the bicubic kernel has negative lobes, the remaining weight
+//! can vanish next to nodata and amplify the sum. Bicubic outputs
+//! whose valid weight is below one half are taken from a bilinear
+//! interpolation instead. Integer outputs are rounded and saturated.
+//!
+//! The output rows are processed in bands, so that the pass 1
+//! intermediate only spans the input rows which a band's taps
+//! cover (at most resize_band bytes). Inputs without NaN skip the
+//! valid weights, which are then the products of the tap weights.
+template<typename T>
+void resize_host(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs, soil::ivec2 out, soil::ivec2 in, const resize_t filter) {
+
+  using V = typename soil::typedesc<T>::value_t;
+  using W = resize_sum_t<V>;
+  constexpr size_t N = sizeof(T) / sizeof(V);
+
+  if (lhs.elem() != size_t(out[0]) * size_t(out[1]))
+    throw soil::error::mismatch_size(size_t(out[0]) * size_t(out[1]), lhs.elem());
+  if (rhs.elem() != size_t(in[0]) * size_t(in[1]))
+    throw soil::error::mismatch_size(size_t(in[0]) * size_t(in[1]), rhs.elem());
+
+  const resize_taps taps0 = resize_table(out[0], in[0], filter);
+  const resize_taps taps1 = resize_table(out[1], in[1], filter);
+
+  const size_t row = size_t(out[1]) * N;
+  const V *src = reinterpret_cast<const V *>(rhs.data());
+  V *dst = reinterpret_cast<V *>(lhs.data());
+
+  // Integer Inputs are NaN-Free
+
+  bool nan = false;
+  if constexpr (!std::is_integral_v<V>) {
+    std::atomic<bool> any{false};
+    soil::parallel_chunk(rhs.elem() * N, host_chunk, [&](const size_t, const size_t start, const size_t stop) {
+      bool found = false;
+      for (size_t k = start; k < stop; ++k) {
+        const double v = double(src[k]);
+        found |= (v != v);
+      }
+      if (found)
+        any = true;
+    });
+    nan = any;
+  }
+
+  const std::vector<double> weight0 = resize_weights(taps0);
+  const std::vector<double> weight1 = resize_weights(taps1);
+
+  // Bilinear Fallback of Bicubic Outputs next to NaN
+
+  const bool fallback = (filter == BICUBIC) && nan;
+  const resize_taps lin0 = fallback ? resize_table(out[0], in[0], BILINEAR) : resize_taps{};
+  const resize_taps lin1 = fallback ? resize_table(out[1], in[1], BILINEAR) : resize_taps{};
+
+  const auto bilinear = [&](const size_t i, const size_t k) {
+    const size_t j = k / N;
+    const size_t n = k % N;
+    double s = 0.0, c = 0.0;
+    for (int a = lin0.offset[i]; a < lin0.offset[i + 1]; ++a) {
+      for (int b = lin1.offset[j]; b < lin1.offset[j + 1]; ++b) {
+        const double v = double(src[(size_t(lin0.index[a]) * size_t(in[1]) + size_t(lin1.index[b])) * N + n]);
+        const double w = lin0.weight[a] * lin1.weight[b];
+        const bool valid = (v == v);
+        s += valid ? w * v : 0.0;
+        c += valid ? w : 0.0;
+      }
+    }
+    return resize_value<V>(s, c);
+  };
+
+  const size_t width = nan ? 2 : 1; // Weighted Sums (and Valid Weights)
+  std::vector<W> band;
+
+  for (int i0 = 0; i0 < out[0];) {
+
+    // Band of Output Rows [i0, i1) over Input Rows [lo, hi]
+
+    int lo = taps0.index[taps0.offset[i0]];
+    int hi = lo;
+    int i1 = i0;
+    while (i1 < out[0]) {
+      int l = lo, h = hi;
+      for (int t = taps0.offset[i1]; t < taps0.offset[i1 + 1]; ++t) {
+        l = std::min(l, taps0.index[t]);
+        h = std::max(h, taps0.index[t]);
+      }
+      if (i1 > i0 && size_t(h - l + 1) * row * width * sizeof(W) > resize_band)
+        break;
+      lo = l;
+      hi = h;
+      ++i1;
+    }
+
+    const size_t rows = size_t(hi - lo + 1);
+    band.resize(rows * row * width);
+    W *sum = band.data();
+    W *wsum = sum + rows * row;
+
+    // Pass 1: Fast Axis, Weighted Sums (and Valid Weights)
+
+    soil::parallel_for(rows, [&](const size_t r) {
+      const V *line = src + (size_t(lo) + r) * size_t(in[1]) * N;
+      W *s = sum + r * row;
+      W *c = wsum + r * row;
+      for (int j = 0; j < out[1]; ++j) {
+        for (size_t n = 0; n < N; ++n) {
+          W sj = 0, cj = 0;
+          for (int t = taps1.offset[j]; t < taps1.offset[j + 1]; ++t) {
+            const W v = W(line[size_t(taps1.index[t]) * N + n]);
+            if (nan) {
+              const bool valid = (v == v);
+              sj += valid ? W(taps1.weight[t]) * v : W(0);
+              cj += valid ? W(taps1.weight[t]) : W(0);
+            } else {
+              sj += W(taps1.weight[t]) * v;
+            }
+          }
+          s[j * N + n] = sj;
+          if (nan)
+            c[j * N + n] = cj;
+        }
+      }
+    }, 16);
+
+    // Pass 2: Slow Axis, Accumulate Rows and Normalize
+
+    soil::parallel_for(size_t(i1 - i0), [&](const size_t b) {
+      const size_t i = size_t(i0) + b;
+      std::vector<W> s(row, W(0)), c(nan ? row : 0, W(0));
+      for (int t = taps0.offset[i]; t < taps0.offset[i + 1]; ++t) {
+        const W w = W(taps0.weight[t]);
+        const W *sr = sum + size_t(taps0.index[t] - lo) * row;
+        for (size_t k = 0; k < row; ++k)
+          s[k] += w * sr[k];
+        if (nan) {
+          const W *cr = wsum + size_t(taps0.index[t] - lo) * row;
+          for (size_t k = 0; k < row; ++k)
+            c[k] += w * cr[k];
+        }
+      }
+      V *line = dst + i * row;
+      for (size_t k = 0; k < row; ++k) {
+        const double ck = nan ? double(c[k]) : weight0[i] * weight1[k / N];
+        if (fallback && ck < 0.5)
+          line[k] = bilinear(i, k);
+        else
+          line[k] = resize_value<V>(double(s[k]), ck);
+      }
+    }, 16);
+
+    i0 = i1;
+  }
+}
 
 template<typename T>
 void resize_impl(soil::buffer_t<T> lhs, const soil::buffer_t<T> rhs, soil::ivec2 out, soil::ivec2 in);
 
 template<typename T>
-void resize(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs, soil::ivec2 out, soil::ivec2 in) {
+void resize(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs, soil::ivec2 out, soil::ivec2 in, const resize_t filter = BILINEAR) {
 
   //  if (lhs.elem() != rhs.elem())
   //    throw soil::error::mismatch_size(lhs.elem(), rhs.elem());
@@ -96,9 +442,11 @@ void resize(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs, soil::ivec2 ou
     throw soil::error::mismatch_host(lhs.host(), rhs.host());
 
   if (lhs.host() == soil::host_t::GPU) {
+    if (filter != BILINEAR)
+      throw std::invalid_argument("only bilinear resize is supported on the GPU");
     resize_impl(lhs, rhs, out, in);
   } else {
-    throw soil::error::mismatch_host(soil::host_t::GPU, rhs.host());
+    resize_host(lhs, rhs, out, in, filter);
   }
 }
 
@@ -127,7 +475,7 @@ T max(const soil::buffer_t<T> &buffer) {
   if (buffer.host() != soil::host_t::CPU)
     throw soil::error::mismatch_host(soil::host_t::CPU, buffer.host());
 
-  T val = std::numeric_limits<T>::min();
+  T val = std::numeric_limits<T>::lowest();
   for (auto [i, b] : buffer.const_iter()) {
     if (!std::isnan(b)) {
       val = std::max(val, b);
@@ -136,6 +484,192 @@ T max(const soil::buffer_t<T> &buffer) {
   return val;
 }
 
+//
+// Statistics Reduction
+//
+
+//! stats_t is the result of a statistics reduction over a buffer.
+//! NaN values are counted, but excluded from all other statistics.
+struct stats_t {
+  size_t count = 0; //!< Number of Non-NaN Values
+  size_t nan = 0;   //!< Number of NaN Values
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double sum = 0.0;
+  double mean = std::numeric_limits<double>::quiet_NaN();
+  double var = std::numeric_limits<double>::quiet_NaN(); //!< Population Variance
+
+  double hist_min = 0.0;    //!< Lower Bound of the First Bin
+  double hist_max = 0.0;    //!< Upper Bound of the Last Bin (Inclusive)
+  std::vector<size_t> hist; //!< Bin Counts (Values outside the Range are not Counted)
+};
+
+namespace {
+
+//! Partial Statistics of a Chunk, with the Sum of Squared Deviations
+struct stats_partial {
+  size_t count = 0;
+  size_t nan = 0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double sum = 0.0;
+  double m2 = 0.0;
+  std::vector<size_t> hist;
+};
+
+//! Merge two Partials (Chan et al.), lhs covering the Lower Indices
+inline void stats_merge(stats_partial &lhs, const stats_partial &rhs) {
+  if (rhs.count > 0 && lhs.count > 0) {
+    const double na = lhs.count, nb = rhs.count;
+    const double delta = rhs.sum / nb - lhs.sum / na;
+    lhs.m2 += rhs.m2 + delta * delta * na * nb / (na + nb);
+  } else if (rhs.count > 0) {
+    lhs.m2 = rhs.m2;
+  }
+  lhs.count += rhs.count;
+  lhs.nan += rhs.nan;
+  lhs.min = std::min(lhs.min, rhs.min);
+  lhs.max = std::max(lhs.max, rhs.max);
+  lhs.sum += rhs.sum;
+  for (size_t b = 0; b < lhs.hist.size(); ++b)
+    lhs.hist[b] += rhs.hist[b];
+}
+
+} // namespace
+
+//! Compute Statistics of a Buffer in a Single Parallel Pass
+//!
+//! Every fixed-size chunk is reduced in two sweeps while it is in the
+//! cache, into independent lanes which are vectorized. The partials of
+//! the chunks are merged pairwise in a fixed tree, so that the result
+//! does not depend on the number of host threads.
+//!
+//! If bins > 0, a histogram over [lo, hi] is computed as well. If the
+//! range is not given (NaN), the min and max of the buffer are used,
+//! which requires an additional pass.
+template<typename T>
+stats_t stats(const soil::buffer_t<T> &buffer, const size_t bins = 0, double lo = std::numeric_limits<double>::quiet_NaN(), double hi = std::numeric_limits<double>::quiet_NaN()) {
+
+  if (buffer.host() != soil::host_t::CPU)
+    throw soil::error::mismatch_host(soil::host_t::CPU, buffer.host());
+
+  if (bins > 0 && (std::isnan(lo) || std::isnan(hi))) {
+    const stats_t range = stats(buffer);
+    lo = std::isnan(lo) ? range.min : lo;
+    hi = std::isnan(hi) ? range.max : hi;
+  }
+
+  if (bins > 0 && !(lo <= hi))
+    throw std::invalid_argument("histogram range is empty");
+
+  const size_t n_chunks = (buffer.elem() + host_chunk - 1) / host_chunk;
+  std::vector<stats_partial> partials(n_chunks);
+  const T *data = buffer.data();
+
+  soil::parallel_chunk(buffer.elem(), host_chunk, [&](const size_t k, const size_t start, const size_t stop) {
+    constexpr size_t W = 8; // Independent Lanes
+    stats_partial &p = partials[k];
+
+    // Sweep 1: Count, Min, Max, Sum
+
+    size_t count[W] = {};
+    double min[W], max[W], sum[W] = {};
+    std::fill_n(min, W, std::numeric_limits<double>::infinity());
+    std::fill_n(max, W, -std::numeric_limits<double>::infinity());
+
+    size_t i = start;
+    for (; i + W <= stop; i += W) {
+      for (size_t l = 0; l < W; ++l) {
+        const double x = double(data[i + l]);
+        const bool valid = (x == x);
+        count[l] += valid;
+        sum[l] += valid ? x : 0.0;
+        min[l] = (valid && x < min[l]) ? x : min[l];
+        max[l] = (valid && x > max[l]) ? x : max[l];
+      }
+    }
+    for (size_t l = 0; i < stop; ++i, ++l) {
+      const double x = double(data[i]);
+      const bool valid = (x == x);
+      count[l] += valid;
+      sum[l] += valid ? x : 0.0;
+      min[l] = (valid && x < min[l]) ? x : min[l];
+      max[l] = (valid && x > max[l]) ? x : max[l];
+    }
+
+    for (size_t l = 0; l < W; ++l) {
+      p.count += count[l];
+      p.sum += sum[l];
+      p.min = std::min(p.min, min[l]);
+      p.max = std::max(p.max, max[l]);
+    }
+    p.nan = (stop - start) - p.count;
+
+    // Sweep 2: Squared Deviations, Histogram
+
+    const double mean = (p.count > 0) ? p.sum / p.count : 0.0;
+    double m2[W] = {};
+    i = start;
+    for (; i + W <= stop; i += W) {
+      for (size_t l = 0; l < W; ++l) {
+        const double x = double(data[i + l]);
+        const double d = (x == x) ? x - mean : 0.0;
+        m2[l] += d * d;
+      }
+    }
+    for (size_t l = 0; i < stop; ++i, ++l) {
+      const double x = double(data[i]);
+      const double d = (x == x) ? x - mean : 0.0;
+      m2[l] += d * d;
+    }
+    for (size_t l = 0; l < W; ++l)
+      p.m2 += m2[l];
+
+    if (bins > 0) {
+      p.hist.assign(bins, 0);
+      const double scale = (hi > lo) ? bins / (hi - lo) : 0.0;
+      for (i = start; i < stop; ++i) {
+        const double x = double(data[i]);
+        if (!(x >= lo && x <= hi))
+          continue;
+        const size_t b = std::min(bins - 1, size_t((x - lo) * scale));
+        ++p.hist[b];
+      }
+    }
+  });
+
+  // Pairwise Tree Merge (Fixed Order)
+
+  for (size_t stride = 1; stride < n_chunks; stride *= 2) {
+    for (size_t k = 0; k + stride < n_chunks; k += 2 * stride)
+      stats_merge(partials[k], partials[k + stride]);
+  }
+
+  stats_t result;
+  if (bins > 0) {
+    result.hist_min = lo;
+    result.hist_max = hi;
+    result.hist.assign(bins, 0);
+  }
+
+  if (n_chunks == 0)
+    return result;
+
+  const stats_partial &p = partials[0];
+  result.count = p.count;
+  result.nan = p.nan;
+  result.min = p.min;
+  result.max = p.max;
+  result.sum = p.sum;
+  if (p.count > 0) {
+    result.mean = p.sum / p.count;
+    result.var = p.m2 / p.count;
+  }
+  if (bins > 0)
+    result.hist = p.hist;
+  return result;
+}
+
 } // end of namespace soil
 
 #endif
\ No newline at end of file
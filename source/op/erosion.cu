@@ -3,6 +3,9 @@
 #define HAS_CUDA
 
 #include <soillib/util/error.hpp>
+#include <soillib/util/atomic.hpp>
+#include <soillib/util/thread.hpp>
+#include <soillib/util/random.hpp>
 
 #include <cuda_runtime.h>
 #include <math_constants.h>
@@ -17,20 +20,23 @@
 namespace soil {
 
 //
-// Randstate and Estimate Initialization / Filtering
+// Sample Generation and Estimate Initialization / Filtering
 //
 
-__global__ void seed(buffer_t<curandState> buffer, const size_t seed, const size_t offset) {
-  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
-  if(n >= buffer.elem()) return;
-  curand_init(seed, n, offset, &buffer[n]);
+//! Sample Position Generation:
+//!   Positions are drawn from a counter-based generator keyed by the
+//!   seed, model age, sample index and pass, so that every sample is
+//!   reproducible regardless of how the work is distributed.
+GPU_ENABLE vec2 sample(const model_t& model, const param_t& param, const size_t n, const unsigned int pass){
+  soil::rand_t rand(param.seed, model.age, n, pass);
+  return vec2{
+    rand.uniform()*float(model.index[0]),
+    rand.uniform()*float(model.index[1])
+  };
 }
 
-__global__ void reset(model_t model){
-  
-  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
-  if(n >= model.elem) return;
-  
+GPU_ENABLE void reset(model_t& model, const size_t n){
+
   // Reset Estimation Buffers
 
   model.discharge_track[n] = 0.0f;
@@ -38,10 +44,7 @@ __global__ void reset(model_t model){
 
 }
 
-__global__ void filter(model_t model, const param_t param){
-
-  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
-  if(n >= model.elem) return;
+GPU_ENABLE void filter(model_t& model, const param_t param, const size_t n){
 
   // Apply Simple Exponential Filter to Noisy Estimates
 
@@ -50,14 +53,27 @@ __global__ void filter(model_t model, const param_t param){
 
 }
 
+__global__ void _reset(model_t model){
+  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
+  if(n >= model.elem) return;
+  reset(model, n);
+}
+
+__global__ void _filter(model_t model, const param_t param){
+  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
+  if(n >= model.elem) return;
+  filter(model, param, n);
+}
+
 //
 // Erosion Kernels
 //
 
-__global__ void solve(model_t model, const size_t N, const param_t param){
-
-  const unsigned int ind = blockIdx.x * blockDim.x + threadIdx.x;
-  if(ind >= N) return;
+//! Single-Sample Erosion Solution:
+//!   Solves the conservation law along the characteristic
+//!   of a single particle, spawned at the sampled position.
+//!   This is shared by the GPU kernel and the host backend.
+GPU_ENABLE void solve(model_t& model, vec2 pos, const size_t N, const param_t param){
 
   //
   // Parameters
@@ -84,11 +100,6 @@ __global__ void solve(model_t model, const size_t N, const param_t param){
   //  on the actual implementation of the sampling procedure.
   //
 
-  curandState* randState = &model.rand[ind];
-  vec2 pos = vec2{
-    curand_uniform(randState)*float(model.index[0]),
-    curand_uniform(randState)*float(model.index[1])
-  };
   const float P = 1.0f / float(model.index.elem());
   int find = model.index.flatten(pos);
 
@@ -146,9 +157,9 @@ __global__ void solve(model_t model, const size_t N, const param_t param){
 
     // Note: Accumulation Occurds at Current Position
 
-    atomicAdd(&model.discharge_track[find], (1.0f/P/N)*vol);
-    atomicAdd(&model.momentum_track[find].x, (1.0f/P/N)*vol*dspeed.x);
-    atomicAdd(&model.momentum_track[find].y, (1.0f/P/N)*vol*dspeed.y);
+    atomic_add(&model.discharge_track[find], (1.0f/P/N)*vol);
+    atomic_add(&model.momentum_track[find].x, (1.0f/P/N)*vol*dspeed.x);
+    atomic_add(&model.momentum_track[find].y, (1.0f/P/N)*vol*dspeed.y);
 
     //
     // Mass-Transfer
@@ -209,7 +220,7 @@ __global__ void solve(model_t model, const size_t N, const param_t param){
 
     if(transfer > 0.0f){  // Add Material to Map (Note: Single Material Model)
 
-      atomicAdd(&model.sediment[find], transfer / Z / Q);
+      atomic_add(&model.sediment[find], transfer / Z / Q);
       sed -= transfer;
 
     }
@@ -218,11 +229,11 @@ __global__ void solve(model_t model, const size_t N, const param_t param){
 
       const float maxtransfer = 0.1f * model.sediment[find] * Z * Q;
       float t1 = transfer * glm::min(1.0f, glm::abs(maxtransfer/transfer));
-      atomicAdd(&model.sediment[find], t1 / Z / Q);
+      atomic_add(&model.sediment[find], t1 / Z / Q);
       sed -= t1;
 
       transfer -= t1;
-      atomicAdd(&model.height[find], transfer / Z / Q);
+      atomic_add(&model.height[find], transfer / Z / Q);
       sed -= transfer;
 
     }
@@ -286,45 +297,95 @@ __global__ void solve(model_t model, const size_t N, const param_t param){
 
 }
 
+__global__ void _solve(model_t model, const size_t N, const param_t param){
+
+  const unsigned int ind = blockIdx.x * blockDim.x + threadIdx.x;
+  if(ind >= N) return;
+
+  const vec2 pos = sample(model, param, ind, 0);
+  solve(model, pos, N, param);
+
+}
+
+__global__ void _debris_flow(model_t model, const size_t N, const param_t param){
+
+  const unsigned int ind = blockIdx.x * blockDim.x + threadIdx.x;
+  if(ind >= N) return;
+
+  // Spawn Particle at Random Position
+
+  const vec2 pos = sample(model, param, ind, 1);
+  debris_flow(model, pos, N, param);
+
+}
+
 //
 // Erosion Function
 //
 
-void erode(model_t& model, const param_t param, const size_t steps){
+void erode_gpu(model_t& model, const param_t param, const size_t steps){
 
-  if(model.height.host() != soil::host_t::GPU){
-    throw soil::error::mismatch_host(soil::host_t::GPU, model.height.host());
-  }
+  const size_t n_samples = param.samples;
 
-  if(model.discharge.host() != soil::host_t::GPU){
-    throw soil::error::mismatch_host(soil::host_t::GPU, model.discharge.host());
-  }
+  //
+  // Estimate Buffers
+  //
 
-  if(model.momentum.host() != soil::host_t::GPU){
-    throw soil::error::mismatch_host(soil::host_t::GPU, model.momentum.host());
+  {
+    soil::buffer_track::scope scope("erode.track");
+    model.discharge_track = soil::buffer_t<float>(model.discharge.elem(), soil::host_t::GPU);
+    model.momentum_track = soil::buffer_t<vec2>(model.discharge.elem(), soil::host_t::GPU);
   }
-  
+
   //
-  // Initialize Rand-State Buffer (One Per Sample)
+  // Execute Solution
   //
 
-  const size_t n_samples = param.samples;
+  for(size_t step = 0; step < steps; ++step){
+
+    //
+    // Reset, Solve, Filter, Apply
+    //
 
-  // note: the offset in the sequence should be number of times rand is sampled
-  // that way the sampling procedure becomes deterministic
+    _reset<<<block(model.elem, 1024), 1024>>>(model);
+    cudaDeviceSynchronize();
 
-  if(model.rand.elem() != n_samples){
-    model.rand = soil::buffer_t<curandState>(n_samples, soil::host_t::GPU);
-    seed<<<block(n_samples, 512), 512>>>(model.rand, 0, 2 * model.age);
+    _solve<<<block(n_samples, 512), 512>>>(model, n_samples, param);
     cudaDeviceSynchronize();
+ 
+    _filter<<<block(model.elem, 1024), 1024>>>(model, param);
+    cudaDeviceSynchronize();
+
+    //
+    // Debris Flow Kernel
+    //
+
+    _debris_flow<<<block(n_samples, 512), 512>>>(model, n_samples, param);
+    cudaDeviceSynchronize();
+
+    model.age++; // Increment Model Age for Sample Generation
+
   }
 
+}
+
+//! Host Erosion Backend:
+//!   Executes the same per-sample solution as the GPU kernels,
+//!   with the samples distributed over the host thread pool.
+//!   Estimates are scattered using host atomics.
+void erode_cpu(model_t& model, const param_t param, const size_t steps){
+
+  const size_t n_samples = param.samples;
+
   //
   // Estimate Buffers
   //
 
-  model.discharge_track = soil::buffer_t<float>(model.discharge.elem(), soil::host_t::GPU);
-  model.momentum_track = soil::buffer_t<vec2>(model.discharge.elem(), soil::host_t::GPU);
+  {
+    soil::buffer_track::scope scope("erode.track");
+    model.discharge_track = soil::buffer_t<float>(model.discharge.elem(), soil::host_t::CPU);
+    model.momentum_track = soil::buffer_t<vec2>(model.discharge.elem(), soil::host_t::CPU);
+  }
 
   //
   // Execute Solution
@@ -336,24 +397,52 @@ void erode(model_t& model, const param_t param, const size_t steps){
     // Reset, Solve, Filter, Apply
     //
 
-    reset<<<block(model.elem, 1024), 1024>>>(model);
-    cudaDeviceSynchronize();
+    soil::parallel_for(model.elem, [&model](const size_t n){
+      reset(model, n);
+    });
 
-    solve<<<block(n_samples, 512), 512>>>(model, n_samples, param);
-    cudaDeviceSynchronize();
- 
-    filter<<<block(model.elem, 1024), 1024>>>(model, param);
-    cudaDeviceSynchronize();
+    soil::parallel_for(n_samples, [&](const size_t n){
+      solve(model, sample(model, param, n, 0), n_samples, param);
+    }, 256);
+
+    soil::parallel_for(model.elem, [&model, &param](const size_t n){
+      filter(model, param, n);
+    });
 
     //
-    // Debris Flow Kernel
+    // Debris Flow
     //
 
-    debris_flow<<<block(n_samples, 512), 512>>>(model, n_samples, param);
-    cudaDeviceSynchronize();
+    soil::parallel_for(n_samples, [&](const size_t n){
+      debris_flow(model, sample(model, param, n, 1), n_samples, param);
+    }, 256);
+
+    model.age++; // Increment Model Age for Sample Generation
+
+  }
+
+}
+
+void erode(model_t& model, const param_t param, const size_t steps){
+
+  const soil::host_t host = model.height.host();
 
-    model.age++; // Increment Model Age for Rand-State Initialization
+  if(model.sediment.host() != host){
+    throw soil::error::mismatch_host(host, model.sediment.host());
+  }
+
+  if(model.discharge.host() != host){
+    throw soil::error::mismatch_host(host, model.discharge.host());
+  }
+
+  if(model.momentum.host() != host){
+    throw soil::error::mismatch_host(host, model.momentum.host());
+  }
 
+  if(host == soil::host_t::GPU){
+    erode_gpu(model, param, steps);
+  } else {
+    erode_cpu(model, param, steps);
   }
 
 }
@@ -5,8 +5,6 @@
 #include <soillib/core/index.hpp>
 #include <soillib/soillib.hpp>
 
-#include <curand_kernel.h>
-
 namespace soil {
 
 //
@@ -17,6 +15,7 @@ struct param_t {
 
   size_t samples = 8192;
   size_t maxage = 128;
+  size_t seed = 0; // Random Sequence Key
   float lrate = 0.2f;
 
   float timeStep = 10.0f; // [y]
@@ -57,10 +56,13 @@ struct model_t {
 
   soil::buffer_t<vec2> momentum;
   soil::buffer_t<vec2> momentum_track;
-
-  soil::buffer_t<curandState> rand;
 };
 
+//! Erode the Model for a Number of Steps
+//!
+//! The solution is computed on the device which holds the model
+//! buffers. GPU models are solved with CUDA kernels, while CPU models
+//! distribute the samples over the host thread pool.
 void erode(model_t &model, const param_t param, const size_t steps);
 
 } // end of namespace soil
@@ -8,6 +8,7 @@
 
 #include <soillib/op/erosion.hpp>
 #include <soillib/op/gather.hpp>
+#include <soillib/util/atomic.hpp>
 
 namespace soil {
 
@@ -37,7 +38,7 @@ namespace soil {
 //!   particle frictions though (e.g. for multi-material interfaces), then the
 //!   term does NOT becomes normalized away and becomes relevant again.
 //! 
-__device__ vec2 steepest_speed(model_t& model, const param_t param, const ivec2 pos) {
+GPU_ENABLE vec2 steepest_speed(model_t& model, const param_t param, const ivec2 pos) {
 
   const vec3 scale = model.scale;
   const float g = param.gravity;
@@ -51,10 +52,10 @@ __device__ vec2 steepest_speed(model_t& model, const param_t param, const ivec2
 
 }
 
-__device__ float _transfer(float* buf, float val, const float max){
+GPU_ENABLE float _transfer(float* buf, float val, const float max){
   if(abs(val) > 1E-8){
     val = val * glm::min(1.0f, max/abs(val)); // Cap Val at Max
-    atomicAdd(buf, val);                      // Transfer Val
+    atomic_add(buf, val);                     // Transfer Val
   }
   return val;                               // Return Value
 }
@@ -73,10 +74,10 @@ __device__ float _transfer(float* buf, float val, const float max){
 //! this causes some stability issues due to the sampling scaling.
 //! Using an implicit method would solve this problem directly.
 //!
-__global__ void debris_flow(model_t model, const size_t N, const param_t param){
-
-  const unsigned int ind = blockIdx.x * blockDim.x + threadIdx.x;
-  if(ind >= model.elem) return;
+//! The particle is spawned at the sampled position, so that the
+//! same implementation is shared by the GPU and host backends.
+//!
+GPU_ENABLE void debris_flow(model_t& model, vec2 pos, const size_t N, const param_t param){
 
   // Parameters
 
@@ -89,13 +90,8 @@ __global__ void debris_flow(model_t model, const size_t N, const param_t param){
 
   float mass = 0.0f;  // Currently Transported Mass
 
-  // Spawn Particle at Random Position
+  // Sampling Probability
 
-  curandState* randState = &model.rand[ind];
-  vec2 pos = vec2{
-    curand_uniform(randState)*float(model.index[0]),
-    curand_uniform(randState)*float(model.index[1])
-  };
   const float P = 1.0f / float(model.index.elem());
   const float Q = P * float(N); // Sampling Probability Scale
 
@@ -186,7 +182,7 @@ __global__ void debris_flow(model_t model, const size_t N, const param_t param){
       transfer = glm::min(transfer, mass);
       transfer = glm::max(0.0f, transfer);
 
-      atomicAdd(&model.sediment[find], transfer / Q / scale.z / Ac);
+      atomic_add(&model.sediment[find], transfer / Q / scale.z / Ac);
       mass -= transfer;
 
     }
@@ -199,11 +195,11 @@ __global__ void debris_flow(model_t model, const size_t N, const param_t param){
       const float maxt1 = hf_1 * Ac * Q;
       float t1 = transfer * glm::min(1.0f, glm::abs(maxt1/transfer));
 
-      atomicAdd(&model.sediment[find], t1 / Q / scale.z / Ac);
+      atomic_add(&model.sediment[find], t1 / Q / scale.z / Ac);
       mass -= t1;
 
       transfer -= t1;
-      atomicAdd(&model.height[find], transfer / Q / Ac / scale.z );
+      atomic_add(&model.height[find], transfer / Q / Ac / scale.z );
       mass -= transfer;
 
     }
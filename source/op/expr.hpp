@@ -0,0 +1,579 @@
+#ifndef SOILLIB_OP_EXPR
+#define SOILLIB_OP_EXPR
+
+#include <soillib/core/buffer.hpp>
+#include <soillib/core/types.hpp>
+#include <soillib/op/common.hpp>
+#include <soillib/util/error.hpp>
+#include <soillib/util/thread.hpp>
+
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace soil {
+
+// Lazy Buffer Expressions
+//
+//  Element-wise buffer algebra like (a + b) * c + d is recorded as an
+//  expression instead of being executed operation by operation, and
+//  is evaluated in a single fused, chunked and parallel pass over the
+//  buffers. This avoids the intermediate buffers and memory passes.
+//
+//  There are two interfaces, which share the element-wise operators:
+//
+//  - Expression templates (static), for use from C++:
+//
+//      auto e = (soil::lazy(a) + soil::lazy(b)) * soil::lazy(c) + 1.0f;
+//      soil::buffer_t<float> out = soil::evaluate(e);
+//
+//  - The soil::expr type (dynamic), a type-erased expression graph
+//    for use from Python, which is compiled at evaluation time.
+//
+//  Comparisons return 1 or 0 in the value type of the expression.
+//  Expressions are evaluated on the CPU, for scalar buffer types.
+
+//
+// Element-Wise Operators
+//
+
+namespace expr_op {
+
+struct add {
+  template<typename T>
+  T operator()(const T a, const T b) const { return a + b; }
+};
+
+struct sub {
+  template<typename T>
+  T operator()(const T a, const T b) const { return a - b; }
+};
+
+struct mul {
+  template<typename T>
+  T operator()(const T a, const T b) const { return a * b; }
+};
+
+struct div {
+  template<typename T>
+  T operator()(const T a, const T b) const { return a / b; }
+};
+
+struct min {
+  template<typename T>
+  T operator()(const T a, const T b) const { return (b < a) ? b : a; }
+};
+
+struct max {
+  template<typename T>
+  T operator()(const T a, const T b) const { return (a < b) ? b : a; }
+};
+
+struct pow {
+  template<typename T>
+  T operator()(const T a, const T b) const { return T(std::pow(a, b)); }
+};
+
+struct lt {
+  template<typename T>
+  T operator()(const T a, const T b) const { return T(a < b); }
+};
+
+struct le {
+  template<typename T>
+  T operator()(const T a, const T b) const { return T(a <= b); }
+};
+
+struct gt {
+  template<typename T>
+  T operator()(const T a, const T b) const { return T(a > b); }
+};
+
+struct ge {
+  template<typename T>
+  T operator()(const T a, const T b) const { return T(a >= b); }
+};
+
+//! 1 if the Value is NaN, 0 otherwise
+struct is_nan {
+  template<typename T>
+  T operator()(const T a) const {
+    if constexpr (std::floating_point<T>)
+      return T(std::isnan(a));
+    else
+      return T(0);
+  }
+};
+
+//! Replace NaN Values by b
+struct fill_nan {
+  template<typename T>
+  T operator()(const T a, const T b) const {
+    return is_nan{}(a) ? b : a;
+  }
+};
+
+//! Keep Values where b is Non-Zero, NaN otherwise
+struct mask {
+  template<typename T>
+  T operator()(const T a, const T b) const {
+    return (b != T(0)) ? a : std::numeric_limits<T>::quiet_NaN();
+  }
+};
+
+struct clamp {
+  template<typename T>
+  T operator()(const T a, const T lo, const T hi) const {
+    return (a < lo) ? lo : (hi < a) ? hi : a;
+  }
+};
+
+//! Select a where c is Non-Zero, b otherwise
+struct where {
+  template<typename T>
+  T operator()(const T c, const T a, const T b) const {
+    return (c != T(0)) ? a : b;
+  }
+};
+
+} // namespace expr_op
+
+//
+// Expression Templates
+//
+
+//! expression is any type which computes a value of type value_t
+//! for a flat index, over elem() elements (zero for scalars).
+template<typename E>
+concept expression = requires(const E &e, const size_t i) {
+  typename E::value_t;
+  { e(i) } -> std::convertible_to<typename E::value_t>;
+  { e.elem() } -> std::convertible_to<size_t>;
+};
+
+//! Buffer Operand
+template<typename T>
+struct expr_leaf {
+  typedef T value_t;
+  expr_leaf(const soil::buffer_t<T> &buffer): buffer{buffer} {}
+  T operator()(const size_t i) const { return this->buffer[i]; }
+  size_t elem() const { return this->buffer.elem(); }
+  soil::buffer_t<T> buffer;
+};
+
+//! Scalar Operand (Broadcast)
+template<typename T>
+struct expr_scalar {
+  typedef T value_t;
+  T operator()(const size_t) const { return this->value; }
+  size_t elem() const { return 0; }
+  T value;
+};
+
+//! Operator Node over Operand Expressions
+template<typename F, expression... E>
+struct expr_node {
+
+  typedef std::common_type_t<typename E::value_t...> value_t;
+
+  expr_node(const F func, const E &...args): func{func},
+                                             args{args...} {
+    for (const size_t n : {size_t(args.elem())...}) {
+      if (n == 0)
+        continue;
+      if (this->_elem != 0 && this->_elem != n)
+        throw soil::error::mismatch_size(this->_elem, n);
+      this->_elem = n;
+    }
+  }
+
+  value_t operator()(const size_t i) const {
+    return std::apply([this, i](const auto &...arg) {
+      return this->func(value_t(arg(i))...);
+    },
+                      this->args);
+  }
+
+  size_t elem() const { return this->_elem; }
+
+private:
+  F func;
+  std::tuple<E...> args;
+  size_t _elem = 0;
+};
+
+//! Create a Lazy Buffer Operand
+template<typename T>
+expr_leaf<T> lazy(const soil::buffer_t<T> &buffer) {
+  return expr_leaf<T>(buffer);
+}
+
+namespace {
+
+template<typename E>
+const E &as_expr(const E &e)
+  requires expression<E>
+{
+  return e;
+}
+
+template<typename T>
+expr_scalar<T> as_expr(const T value)
+  requires std::is_arithmetic_v<T>
+{
+  return expr_scalar<T>{value};
+}
+
+template<typename F, typename... A>
+auto make_expr(const F func, const A &...args) {
+  return expr_node(func, as_expr(args)...);
+}
+
+template<typename A, typename B>
+concept expr_operands = (expression<A> || expression<B>) &&
+                        (expression<A> || std::is_arithmetic_v<A>) &&
+                        (expression<B> || std::is_arithmetic_v<B>);
+
+} // namespace
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator+(const A &a, const B &b) { return make_expr(expr_op::add{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator-(const A &a, const B &b) { return make_expr(expr_op::sub{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator*(const A &a, const B &b) { return make_expr(expr_op::mul{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator/(const A &a, const B &b) { return make_expr(expr_op::div{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator<(const A &a, const B &b) { return make_expr(expr_op::lt{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator<=(const A &a, const B &b) { return make_expr(expr_op::le{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator>(const A &a, const B &b) { return make_expr(expr_op::gt{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto operator>=(const A &a, const B &b) { return make_expr(expr_op::ge{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto minimum(const A &a, const B &b) { return make_expr(expr_op::min{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto maximum(const A &a, const B &b) { return make_expr(expr_op::max{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto pow(const A &a, const B &b) { return make_expr(expr_op::pow{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto fill_nan(const A &a, const B &b) { return make_expr(expr_op::fill_nan{}, a, b); }
+
+template<typename A, typename B>
+  requires expr_operands<A, B>
+auto mask(const A &a, const B &b) { return make_expr(expr_op::mask{}, a, b); }
+
+template<expression A>
+auto is_nan(const A &a) { return make_expr(expr_op::is_nan{}, a); }
+
+template<expression A, typename L, typename H>
+auto clamp(const A &a, const L &lo, const H &hi) { return make_expr(expr_op::clamp{}, a, lo, hi); }
+
+template<expression C, typename A, typename B>
+auto where(const C &c, const A &a, const B &b) { return make_expr(expr_op::where{}, c, a, b); }
+
+//! Evaluate an Expression into a Buffer in a Single Fused Pass
+template<expression E>
+void evaluate(const E &e, soil::buffer_t<typename E::value_t> &out) {
+
+  if (out.host() != soil::host_t::CPU)
+    throw soil::error::mismatch_host(soil::host_t::CPU, out.host());
+
+  if (e.elem() != 0 && e.elem() != out.elem())
+    throw soil::error::mismatch_size(out.elem(), e.elem());
+
+  using T = typename E::value_t;
+  T *data = out.data();
+  soil::parallel_chunk(out.elem(), host_chunk, [&e, data](const size_t, const size_t start, const size_t stop) {
+    for (size_t i = start; i < stop; ++i)
+      data[i] = e(i);
+  });
+}
+
+//! Evaluate an Expression into a New Buffer
+template<expression E>
+soil::buffer_t<typename E::value_t> evaluate(const E &e) {
+  soil::buffer_t<typename E::value_t> out(e.elem());
+  evaluate(e, out);
+  return out;
+}
+
+//
+// Dynamic Expression Graph
+//
+
+//! expr is a type-erased, immutable expression graph over soil::buffer,
+//! whose nodes are shared, so that common sub-expressions are evaluated
+//! only once per element.
+//!
+//! At evaluation, the graph is compiled into a linear program, which is
+//! executed over blocks of elements that stay in the cache. Every
+//! instruction is a tight loop over a block, so that the buffers are
+//! read and written only once, like for the expression templates.
+//!
+struct expr {
+
+  enum op_t {
+    LEAF,
+    SCALAR,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MIN,
+    MAX,
+    POW,
+    LT,
+    LE,
+    GT,
+    GE,
+    IS_NAN,
+    FILL_NAN,
+    MASK,
+    CLAMP,
+    WHERE
+  };
+
+  expr(const soil::buffer &buffer);
+  expr(const double value);
+
+  //! Apply an Operator to a Set of Operand Expressions
+  static expr apply(const op_t op, const std::vector<expr> &args);
+
+  soil::dtype type() const { return this->node->type; } //!< Value Type (NONE for Scalars)
+  size_t elem() const { return this->node->elem; }      //!< Number of Elements (Zero for Scalars)
+
+  soil::buffer evaluate() const;        //!< Evaluate into a New Buffer (CPU)
+  void evaluate(soil::buffer &out) const; //!< Evaluate into an Existing Buffer (CPU)
+
+private:
+  struct node_t {
+    op_t op;
+    std::vector<std::shared_ptr<const node_t>> args;
+    soil::buffer buffer;
+    double value = 0.0;
+    soil::dtype type = soil::NONE;
+    size_t elem = 0;
+  };
+
+  expr(std::shared_ptr<const node_t> node): node{node} {}
+
+  template<typename T>
+  void evaluate(soil::buffer_t<T> &out) const;
+
+  std::shared_ptr<const node_t> node;
+};
+
+inline expr::expr(const soil::buffer &buffer) {
+  if (buffer.host() != soil::host_t::CPU)
+    throw soil::error::mismatch_host(soil::host_t::CPU, buffer.host());
+  auto node = std::make_shared<node_t>();
+  node->op = LEAF;
+  node->buffer = buffer;
+  node->type = buffer.type();
+  node->elem = buffer.elem();
+  this->node = node;
+}
+
+inline expr::expr(const double value) {
+  auto node = std::make_shared<node_t>();
+  node->op = SCALAR;
+  node->value = value;
+  this->node = node;
+}
+
+inline expr expr::apply(const op_t op, const std::vector<expr> &args) {
+
+  const size_t arity = (op == IS_NAN) ? 1 : (op == CLAMP || op == WHERE) ? 3
+                                                                          : 2;
+  if (op == LEAF || op == SCALAR || args.size() != arity)
+    throw std::invalid_argument("invalid expression operator or number of operands");
+
+  auto node = std::make_shared<node_t>();
+  node->op = op;
+  for (const auto &arg : args) {
+    const node_t &a = *arg.node;
+    if (a.type != soil::NONE) {
+      if (node->type != soil::NONE && node->type != a.type)
+        throw soil::error::mismatch_type(node->type, a.type);
+      node->type = a.type;
+    }
+    if (a.elem != 0) {
+      if (node->elem != 0 && node->elem != a.elem)
+        throw soil::error::mismatch_size(node->elem, a.elem);
+      node->elem = a.elem;
+    }
+    node->args.push_back(arg.node);
+  }
+  return expr(node);
+}
+
+inline soil::buffer expr::evaluate() const {
+  if (this->type() == soil::NONE)
+    throw std::invalid_argument("expression has no buffer operands");
+  soil::buffer out(this->type(), this->elem());
+  this->evaluate(out);
+  return out;
+}
+
+inline void expr::evaluate(soil::buffer &out) const {
+
+  if (this->type() != soil::NONE && out.type() != this->type())
+    throw soil::error::mismatch_type(out.type(), this->type());
+
+  soil::select(out.type(), [&]<typename T>()
+                             requires std::is_arithmetic_v<T>
+                           {
+                             auto out_t = out.as<T>();
+                             this->evaluate<T>(out_t);
+                           });
+}
+
+template<typename T>
+void expr::evaluate(soil::buffer_t<T> &out) const {
+
+  if (out.host() != soil::host_t::CPU)
+    throw soil::error::mismatch_host(soil::host_t::CPU, out.host());
+
+  if (this->elem() != 0 && this->elem() != out.elem())
+    throw soil::error::mismatch_size(out.elem(), this->elem());
+
+  // Compile: Post-Order Program, Shared Nodes are Visited Once
+
+  struct instr_t {
+    op_t op;
+    int args[3] = {-1, -1, -1};
+    const T *data = NULL; //!< Leaf Data
+    T value = T(0);       //!< Scalar Value
+  };
+
+  std::vector<instr_t> program;
+  std::unordered_map<const node_t *, int> visited;
+
+  const auto compile = [&](const auto &self, const node_t *node) -> int {
+    if (const auto it = visited.find(node); it != visited.end())
+      return it->second;
+    instr_t instr{node->op};
+    for (size_t a = 0; a < node->args.size(); ++a)
+      instr.args[a] = self(self, node->args[a].get());
+    if (node->op == LEAF)
+      instr.data = node->buffer.as<T>().data();
+    if (node->op == SCALAR)
+      instr.value = T(node->value);
+    program.push_back(instr);
+    return visited[node] = program.size() - 1;
+  };
+  compile(compile, this->node.get());
+
+  // Execute: Blocks of K Elements per Instruction
+
+  constexpr size_t K = 256;
+  T *data = out.data();
+
+  soil::parallel_chunk(out.elem(), host_chunk, [&](const size_t, const size_t start, const size_t stop) {
+    std::vector<T> scratch(K * program.size());
+    std::vector<const T *> regs(program.size());
+
+    for (size_t p = 0; p < program.size(); ++p) {
+      if (program[p].op == SCALAR)
+        std::fill_n(scratch.data() + K * p, K, program[p].value);
+    }
+
+    for (size_t b = start; b < stop; b += K) {
+      const size_t n = std::min(K, stop - b);
+
+      for (size_t p = 0; p < program.size(); ++p) {
+        const instr_t &instr = program[p];
+        T *reg = (p + 1 == program.size()) ? data + b : scratch.data() + K * p;
+        const T *x = (instr.args[0] < 0) ? NULL : regs[instr.args[0]];
+        const T *y = (instr.args[1] < 0) ? NULL : regs[instr.args[1]];
+        const T *z = (instr.args[2] < 0) ? NULL : regs[instr.args[2]];
+
+        // Full Blocks are Computed into a Local Array, which can't
+        // alias the operands, so that the loop is vectorized.
+        const auto run = [&](const auto f, const auto *...in) {
+          if (n == K) {
+            T block[K];
+            for (size_t i = 0; i < K; ++i)
+              block[i] = f(in[i]...);
+            std::copy_n(block, K, reg);
+          } else {
+            for (size_t i = 0; i < n; ++i)
+              reg[i] = f(in[i]...);
+          }
+        };
+        const auto unary = [&](const auto f) { run(f, x); };
+        const auto binary = [&](const auto f) { run(f, x, y); };
+        const auto ternary = [&](const auto f) { run(f, x, y, z); };
+
+        switch (instr.op) {
+        case LEAF:
+          // Note: A Leaf can be the Output (in-place), then
+          //  the copy would overlap and is skipped.
+          if (p + 1 == program.size() && instr.data + b != reg)
+            std::copy_n(instr.data + b, n, reg);
+          else
+            reg = const_cast<T *>(instr.data + b);
+          break;
+        case SCALAR:
+          if (p + 1 == program.size())
+            std::fill_n(reg, n, instr.value);
+          else
+            reg = scratch.data() + K * p;
+          break;
+        case ADD: binary(expr_op::add{}); break;
+        case SUB: binary(expr_op::sub{}); break;
+        case MUL: binary(expr_op::mul{}); break;
+        case DIV: binary(expr_op::div{}); break;
+        case MIN: binary(expr_op::min{}); break;
+        case MAX: binary(expr_op::max{}); break;
+        case POW: binary(expr_op::pow{}); break;
+        case LT: binary(expr_op::lt{}); break;
+        case LE: binary(expr_op::le{}); break;
+        case GT: binary(expr_op::gt{}); break;
+        case GE: binary(expr_op::ge{}); break;
+        case IS_NAN: unary(expr_op::is_nan{}); break;
+        case FILL_NAN: binary(expr_op::fill_nan{}); break;
+        case MASK: binary(expr_op::mask{}); break;
+        case CLAMP: ternary(expr_op::clamp{}); break;
+        case WHERE: ternary(expr_op::where{}); break;
+        }
+        regs[p] = reg;
+      }
+    }
+  });
+}
+
+} // end of namespace soil
+
+#endif
@@ -4,12 +4,23 @@
 
 #include <soillib/op/common.hpp>
 #include <soillib/op/flow.hpp>
+#include <soillib/util/atomic.hpp>
+#include <soillib/util/random.hpp>
+#include <soillib/util/thread.hpp>
 
 #include <cuda_runtime.h>
-#include <curand_kernel.h>
 #include <math_constants.h>
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace {
@@ -40,26 +51,10 @@ __device__ const int dirmap[8] = {
   7, 8, 1, 2, 3, 4, 5, 6,
 };
 
-//! \todo make this robust for non-regular tile shapes (test)
-__device__ soil::ivec2 tile_unflatten(const unsigned int ind, const int w, const int h){
-
-  constexpr int tile_w = 8;
-  constexpr int tile_h = 8;
-  constexpr int tile_s = tile_w * tile_h;
-
-  // Binned Tile Index, Tile Position
-
-  unsigned int tile_ind = ind / tile_s;
-  unsigned int tile_x = tile_w * (tile_ind / (h / tile_h));
-  unsigned int tile_y = tile_h * (tile_ind % (h / tile_h));
-
-  unsigned int tile_pos = ind % tile_s;
-  unsigned int x = tile_x + tile_pos / tile_h;
-  unsigned int y = tile_y + tile_pos % tile_h;
-
-  return soil::ivec2(x, y);
-
-}
+//! 2D Index Layouts of the Per-Cell Operations:
+//!   Padding cells of a tiled layout are skipped.
+template<typename I>
+concept layout_2D = std::same_as<I, soil::flat_t<2>> || std::same_as<I, soil::tiled_t<2>>;
 
 }
 
@@ -67,16 +62,19 @@ __device__ soil::ivec2 tile_unflatten(const unsigned int ind, const int w, const
 // Flow Kernel Implementation
 //
 
-template<typename T>
-__global__ void _flow(soil::buffer_t<T> in, soil::buffer_t<int> out, soil::flat_t<2> index){
+template<typename T, typename I>
+__global__ void _flow(soil::buffer_t<T> in, soil::buffer_t<int> out, I index){
 
   const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
   if(i >= in.elem()) return;
 
   const glm::ivec2 pos = index.unflatten(i);
   size_t ind = i;
-//  soil::ivec2 pos = tile_unflatten(i, index[1]);
-//  size_t ind = index.flatten(pos);
+
+  if(index.oob(pos)){ // Note: Tile Padding
+    out[ind] = -2;
+    return;
+  }
 
   T diffmax = 0.0f;
   T hvalue = in[ind];
@@ -122,7 +120,7 @@ __global__ void _flow(soil::buffer_t<T> in, soil::buffer_t<int> out, soil::flat_
 
 soil::buffer soil::flow(const soil::buffer& buffer, const soil::index& index) {
 
-  return soil::select(index.type(), [&]<std::same_as<soil::flat_t<2>> I>() {
+  return soil::select(index.type(), [&]<layout_2D I>() {
     return soil::select(buffer.type(), [&]<std::floating_point T>(){
 
       auto index_t = index.as<I>();
@@ -163,7 +161,7 @@ __global__ void _direction(soil::buffer_t<int> in, soil::buffer_t<glm::ivec2> ou
 
 soil::buffer soil::direction(const soil::buffer& buffer, const soil::index& index){
 
-  return soil::select(index.type(), [&]<std::same_as<soil::flat_t<2>> I>() {
+  return soil::select(index.type(), [&]<layout_2D I>() {
     return soil::select(buffer.type(), [&]<std::same_as<int> T>(){
 
       auto index_t = index.as<I>();
@@ -184,6 +182,214 @@ soil::buffer soil::direction(const soil::buffer& buffer, const soil::index& inde
 
 }
 
+//
+// Conditioning Implementation
+//
+
+namespace {
+
+//! Host-Side Moore Neighborhood (Order of coords)
+constexpr int moore[8][2] = {
+  {-1, 0}, {-1, 1}, { 0, 1}, { 1, 1},
+  { 1, 0}, { 1,-1}, { 0,-1}, {-1,-1},
+};
+
+//! Radix Heap: Bucketed monotone priority queue (Ahuja et al. 1990).
+//!   Keys must not be smaller than the last popped key, which holds for
+//!   the spill heights of Priority-Flood. Elements are binned by the highest
+//!   bit differing from the last key and redistributed lazily, which
+//!   replaces the O(log N) sift of a binary heap with sequential appends.
+//!   Floating point keys are mapped to order-preserving unsigned integers.
+template<std::floating_point T>
+struct radix_heap {
+
+  using key_t = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+  static constexpr int bits = 8*sizeof(key_t);
+
+  static key_t key(const T value){
+    const key_t k = std::bit_cast<key_t>(value);
+    constexpr key_t sign = key_t(1) << (bits - 1);
+    return (k & sign) ? ~k : (k | sign);
+  }
+
+  bool empty() const { return this->size == 0; }
+
+  void push(const T value, const int ind){
+    const key_t k = key(value);
+    this->buckets[this->bucket(k)].push_back({k, ind});
+    ++this->size;
+  }
+
+  int pop(){
+    if(this->buckets[0].empty()){
+      int b = 1;
+      while(this->buckets[b].empty())
+        ++b;
+      auto& from = this->buckets[b];
+      this->last = std::min_element(from.begin(), from.end())->first;
+      for(const auto& node: from)
+        this->buckets[this->bucket(node.first)].push_back(node);
+      from.clear();
+    }
+    const int ind = this->buckets[0].back().second;
+    this->buckets[0].pop_back();
+    --this->size;
+    return ind;
+  }
+
+private:
+  int bucket(const key_t k) const {
+    return (k == this->last) ? 0 : std::bit_width(key_t(k ^ this->last));
+  }
+
+  std::vector<std::pair<key_t, int>> buckets[bits + 1];
+  key_t last = 0;
+  size_t size = 0;
+};
+
+//! Minimal Raise: Smallest value strictly above the spill height,
+//!   either by epsilon or by a single unit in the last place.
+template<std::floating_point T>
+T raise(const T value, const T epsilon){
+  const T next = value + epsilon;
+  if(next > value) return next;
+  return std::nextafter(value, std::numeric_limits<T>::infinity());
+}
+
+}
+
+soil::buffer soil::condition(const soil::buffer& buffer, const soil::index& index, const double epsilon){
+
+  return soil::select(index.type(), [&]<layout_2D I>() {
+    return soil::select(buffer.type(), [&]<std::floating_point T>(){
+
+      auto index_t = index.as<I>();
+      auto buffer_t = buffer.as<T>();
+      buffer_t.to_cpu();
+
+      const size_t elem = index_t.elem();
+      auto out = soil::buffer_t<T>{elem, soil::CPU};
+      std::vector<uint8_t> closed(elem, 0);
+
+      // Seed Cells: Domain Boundary or Adjacent to No-Data (NaN),
+      //  which are the outlets of the conditioned height-map.
+
+      soil::parallel_for(elem, [&](const size_t ind){
+
+        const glm::ivec2 pos = index_t.unflatten(ind);
+        if(index_t.oob(pos)){ // Note: Tile Padding
+          out[ind] = std::numeric_limits<T>::quiet_NaN();
+          closed[ind] = 1;
+          return;
+        }
+
+        const T value = buffer_t[ind];
+        out[ind] = value;
+
+        if(std::isnan(value)){
+          closed[ind] = 1;
+          return;
+        }
+
+        for(const auto& [dx, dy]: moore){
+          const glm::ivec2 npos = pos + glm::ivec2(dx, dy);
+          if(index_t.oob(npos) || std::isnan(buffer_t[index_t.flatten(npos)])){
+            closed[ind] = 2;
+            return;
+          }
+        }
+
+      });
+
+      // Priority-Flood + Epsilon (Barnes et al. 2014):
+      //  Cells are closed in order of their spill height. Cells at or
+      //  below the spill height of the current cell are raised above it
+      //  and drained through a plain FIFO queue.
+      //
+      //  Slope cells (Zhou et al. 2016), i.e. cells which are above their
+      //  spill height and have no open neighbor at or below themselves,
+      //  can't raise any other cell and are traced through a second FIFO
+      //  queue, so that the priority queue only holds potential spills.
+      //  All keys pushed to the priority queue are at or above the last
+      //  popped key, so that a monotone (radix) heap can be used.
+
+      radix_heap<T> open;
+      std::queue<int> pit;
+      std::queue<int> slope;
+
+      for(size_t ind = 0; ind < elem; ++ind){
+        if(closed[ind] == 2)
+          open.push(out[ind], ind);
+      }
+
+      const T eps = T(epsilon);
+      while(!open.empty() || !pit.empty() || !slope.empty()){
+
+        int ind;
+        if(!pit.empty()){
+          ind = pit.front();
+          pit.pop();
+        } else if(!slope.empty()){
+          ind = slope.front();
+          slope.pop();
+        } else {
+          ind = open.pop();
+        }
+
+        const T value = out[ind];
+        const glm::ivec2 pos = index_t.unflatten(ind);
+
+        // Defer Slope Cells which became Potential Spills
+
+        if(closed[ind] == 3){
+          closed[ind] = 1;
+          bool spill = false;
+          for(const auto& [dx, dy]: moore){
+            const glm::ivec2 npos = pos + glm::ivec2(dx, dy);
+            if(index_t.oob(npos))
+              continue;
+            const int next = index_t.flatten(npos);
+            if(!closed[next] && out[next] <= value){
+              spill = true;
+              break;
+            }
+          }
+          if(spill){
+            open.push(value, ind);
+            continue;
+          }
+        }
+
+        for(const auto& [dx, dy]: moore){
+
+          const glm::ivec2 npos = pos + glm::ivec2(dx, dy);
+          if(index_t.oob(npos))
+            continue;
+
+          const int next = index_t.flatten(npos);
+          if(closed[next])
+            continue;
+
+          if(out[next] <= value){
+            closed[next] = 1;
+            out[next] = raise(value, eps);
+            pit.push(next);
+          } else {
+            closed[next] = 3;
+            slope.push(next);
+          }
+
+        }
+
+      }
+
+      return std::move(soil::buffer(std::move(out)));
+
+    });
+  });
+
+}
+
 //
 // Utility Kernels
 //
@@ -195,25 +401,24 @@ __global__ void _fill(soil::buffer_t<T> buf, const T val){
   buf[index] = val;
 }
 
-__global__ void seed(soil::buffer_t<curandState> buffer, const size_t seed, const size_t offset) {
-  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
-  if(n >= buffer.elem()) return;
-  curand_init(seed, n, offset, &buffer[n]);
+//! Successor Index: Flat index of the downstream cell,
+//!   or the cell itself if it flows out of the domain.
+GPU_ENABLE int successor(const soil::buffer_t<glm::ivec2>& in, const soil::flat_t<2>& index, const int ind){
+
+  const soil::ivec2 pos = index.unflatten(ind);
+  const soil::ivec2 dir = in[ind];
+
+  if(index.oob(pos + dir))
+    return ind;
+  return index.flatten(pos + dir);
+
 }
 
 __global__ void _graph(const soil::buffer_t<glm::ivec2> in, soil::buffer_t<int> graph, soil::flat_t<2> index){
 
   const int ind = blockIdx.x * blockDim.x + threadIdx.x;
   if(ind >= graph.elem()) return;
-
-  const soil::ivec2 pos = index.unflatten(ind);
-  const soil::ivec2 dir = in[ind];
-  
-  if(index.oob(pos + dir)){
-    graph[ind] = ind;
-  } else {
-    graph[ind] = index.flatten(pos + dir);
-  }
+  graph[ind] = successor(in, index, ind);
 
 }
 
@@ -239,6 +444,134 @@ __global__ void _shift(const soil::buffer_t<int> graph_a, soil::buffer_t<int> gr
   }
 }
 
+//
+// Flow Graph Implementation
+//
+
+soil::flow_graph::flow_graph(const soil::buffer& direction, const soil::index& index){
+
+  soil::select(index.type(), [&]<std::same_as<soil::flat_t<2>> I>(){});
+  soil::select(direction.type(), [&]<std::same_as<soil::ivec2> T>(){});
+
+  auto index_t = index.as<soil::flat_t<2>>();
+  auto buffer_t = direction.as<soil::ivec2>();
+  buffer_t.to_cpu();
+
+  const size_t elem = index_t.elem();
+  constexpr size_t chunk = 1 << 16;
+
+  soil::buffer_track::scope scope("flow.graph");
+
+  this->index = index_t;
+  this->next = soil::buffer_t<int>(elem, soil::CPU);
+  this->offset = soil::buffer_t<int>(elem + 1, soil::CPU);
+  this->donors = soil::buffer_t<int>(elem, soil::CPU);
+  this->order = soil::buffer_t<int>(elem, soil::CPU);
+
+  auto& next = this->next;
+  auto& offset = this->offset;
+  auto& donors = this->donors;
+  auto& order = this->order;
+
+  // Successor Index, Donor Count per Cell
+
+  offset[0] = 0;
+  soil::parallel_for(elem, [&](const size_t ind){
+    next[ind] = successor(buffer_t, index_t, ind);
+    offset[ind + 1] = 0;
+  });
+
+  soil::parallel_for(elem, [&](const size_t ind){
+    if(next[ind] != int(ind))
+      std::atomic_ref<int>(offset[next[ind] + 1]).fetch_add(1, std::memory_order_relaxed);
+  });
+
+  // Inclusive Scan: Per-Chunk Sums, then Chunk Offsets
+
+  const size_t n_chunks = (elem + chunk - 1) / chunk;
+  std::vector<int> partial(n_chunks, 0);
+
+  soil::parallel_chunk(elem, chunk, [&](const size_t k, const size_t start, const size_t stop){
+    int sum = 0;
+    for(size_t i = start; i < stop; ++i){
+      sum += offset[i + 1];
+      offset[i + 1] = sum;
+    }
+    partial[k] = sum;
+  });
+
+  for(size_t k = 1; k < n_chunks; ++k)
+    partial[k] += partial[k-1];
+
+  soil::parallel_chunk(elem, chunk, [&](const size_t k, const size_t start, const size_t stop){
+    if(k == 0) return;
+    for(size_t i = start; i < stop; ++i)
+      offset[i + 1] += partial[k-1];
+  });
+
+  // Scatter Donors, Sort Ranges
+
+  std::vector<int> cursor(offset.data(), offset.data() + elem);
+  soil::parallel_for(elem, [&](const size_t ind){
+    if(next[ind] != int(ind)){
+      const int pos = std::atomic_ref<int>(cursor[next[ind]]).fetch_add(1, std::memory_order_relaxed);
+      donors[pos] = ind;
+    }
+  });
+
+  soil::parallel_for(elem, [&](const size_t ind){
+    std::sort(donors.data() + offset[ind], donors.data() + offset[ind + 1]);
+  });
+
+  // Topological Order (Leaf-Peeling Wavefront):
+  //  Starting from the cells without donors, every wavefront releases
+  //  the successors whose donors are then all complete. Cells on a cycle
+  //  are never released and are not part of the order.
+
+  std::vector<uint8_t> pending(elem);
+  soil::parallel_for(elem, [&](const size_t ind){
+    pending[ind] = offset[ind + 1] - offset[ind];
+  });
+
+  std::vector<int> levels{0};
+  for(size_t ind = 0; ind < elem; ++ind){
+    if(pending[ind] == 0)
+      order[levels.back()++] = ind;
+  }
+  levels.insert(levels.begin(), 0);
+
+  std::vector<std::vector<int>> parts;
+  while(levels.back() > levels[levels.size() - 2]){
+
+    const int begin = levels[levels.size() - 2];
+    const int end = levels.back();
+
+    parts.assign((end - begin + 1023) / 1024, {});
+    soil::parallel_chunk(end - begin, 1024, [&](const size_t k, const size_t start, const size_t stop){
+      for(size_t f = begin + start; f < begin + stop; ++f){
+        const int ind = order[f];
+        const int n = next[ind];
+        if(n == ind)
+          continue;
+        if(std::atomic_ref<uint8_t>(pending[n]).fetch_sub(1, std::memory_order_relaxed) == 1)
+          parts[k].push_back(n);
+      }
+    });
+
+    int pos = end;
+    for(const auto& part: parts)
+      for(const int ind: part)
+        order[pos++] = ind;
+    levels.push_back(pos);
+
+  }
+  levels.pop_back();
+
+  this->levels = soil::buffer_t<int>(levels.size(), soil::CPU);
+  std::copy(levels.begin(), levels.end(), this->levels.data());
+
+}
+
 //
 // Sample Generation Procedures
 //
@@ -250,13 +583,14 @@ struct sample_t {
 
 //! Spatially Uniform Sampling:
 //!   Generates a floating point value in the uniform
-//!   interval [0, 1] and computes the flat buffer index. 
-__device__ sample_t sample_uniform(const size_t ind, soil::flat_t<2>& index, soil::buffer_t<curandState>& randStates){
+//!   interval [0, 1) and computes the flat buffer index. 
+GPU_ENABLE sample_t sample_uniform(soil::rand_t& rand, const soil::flat_t<2>& index){
 
-  curandState* state = &randStates[ind];
+  const int elem = index.elem();
+  const int ind = rand.uniform()*float(elem);
   return {
-    curand_uniform(state)*index.elem(),
-    float(index.elem())
+    (ind < elem)?ind:(elem-1), // Note: Float Rounding at Large Extents
+    float(elem)
   };
 
 }
@@ -273,9 +607,7 @@ __device__ sample_t sample_uniform(const size_t ind, soil::flat_t<2>& index, soi
 //!   as a scaling factor can be factored out of the ration between the
 //!   selected sample's weight and the sum of all weights.
 //!
-__device__ sample_t sample_reservoir(const size_t ind, soil::flat_t<2>& index, soil::buffer_t<curandState>& randStates, const soil::buffer_t<float>& weights){
-
-  curandState* state = &randStates[ind];
+GPU_ENABLE sample_t sample_reservoir(soil::rand_t& rand, const soil::flat_t<2>& index, const soil::buffer_t<float>& weights){
 
   int sample = 0;
   float p_sample = 1.0f;
@@ -286,7 +618,7 @@ __device__ sample_t sample_reservoir(const size_t ind, soil::flat_t<2>& index, s
   for(int m = 0; m < M; ++m){
    
     // Sampling Distribution: Uniform
-    auto [next, w_next] = sample_uniform(ind, index, randStates);  
+    auto [next, w_next] = sample_uniform(rand, index);
 
     // Target Distributin (Unnormalized)
     float p_target = weights[next]; // Target Distribution
@@ -295,7 +627,7 @@ __device__ sample_t sample_reservoir(const size_t ind, soil::flat_t<2>& index, s
     float w = w_next * p_target;  // Sample Weight
     w_sum += w;                   // Total Weight
 
-    if(curand_uniform(state) <  w / w_sum){
+    if(rand.uniform() < w / w_sum){
       sample = next;
       p_sample = p_target;
     }
@@ -310,55 +642,59 @@ __device__ sample_t sample_reservoir(const size_t ind, soil::flat_t<2>& index, s
 // Accumulation Kernel Implementation
 //
 
-//! Accumulation Kernel w. Uniform Weight of 1.0
-__global__ void _accumulate(const soil::buffer_t<int> graph, soil::buffer_t<float> out, soil::flat_t<2> index, soil::buffer_t<curandState> randStates, const size_t K, const size_t N){
-
-  const int k = blockIdx.x * blockDim.x + threadIdx.x;
-  if(k >= K) return;
+//! Accumulate a Sample Path w. Uniform Weight of 1.0
+GPU_ENABLE void accumulate(const soil::buffer_t<int>& graph, soil::buffer_t<float>& out, const soil::flat_t<2>& index, soil::rand_t& rand, const size_t N){
 
-  auto [ind, w] = sample_uniform(k, index, randStates);
+  auto [ind, w] = sample_uniform(rand, index);
   //
   int next = graph[ind];
 
   while(ind != next){
     ind = next;
-    atomicAdd(&(out[ind]), w/float(N));
+    soil::atomic_add(&(out[ind]), w/float(N));
     next = graph[ind];
   }
 
 }
 
-//! Accumulation Kernel w. Non-Uniform Weight Buffer
-__global__ void _accumulate(const soil::buffer_t<int> graph, const soil::buffer_t<float> weights, soil::buffer_t<float> out, soil::flat_t<2> index, soil::buffer_t<curandState> randStates, const size_t K, const size_t N, const bool reservoir){
+//! Accumulate a Sample Path w. Non-Uniform Weight Buffer
+GPU_ENABLE void accumulate(const soil::buffer_t<int>& graph, const soil::buffer_t<float>& weights, soil::buffer_t<float>& out, const soil::flat_t<2>& index, soil::rand_t& rand, const size_t N, const bool reservoir){
+
+  auto [ind, w] = reservoir
+    ? sample_reservoir(rand, index, weights)
+    : sample_uniform(rand, index);
+
+  int next = graph[ind];
+  const float val = weights[ind];
+  soil::atomic_add(&(out[ind]), w*val/float(N));
+
+  while(ind != next){
+    ind = next;
+    next = graph[ind];
+    soil::atomic_add(&(out[ind]), w*val/float(N));
+  }
+
+}
+
+//! Accumulation Kernel w. Uniform Weight of 1.0
+__global__ void _accumulate(const soil::buffer_t<int> graph, soil::buffer_t<float> out, soil::flat_t<2> index, const size_t seed, const size_t iteration, const size_t K, const size_t N){
 
   const int k = blockIdx.x * blockDim.x + threadIdx.x;
   if(k >= K) return;
 
-  if(reservoir){
+  soil::rand_t rand(seed, iteration, k);
+  accumulate(graph, out, index, rand, N);
 
-    auto [ind, w] = sample_reservoir(k, index, randStates, weights);
-    int next = graph[ind];
-    const float val = weights[ind];
-    atomicAdd(&(out[ind]), w*val/float(N));
+}
 
-    while(ind != next){
-      ind = next;
-      next = graph[ind];
-      atomicAdd(&(out[ind]), w*val/float(N));
-    }
-  } else {
+//! Accumulation Kernel w. Non-Uniform Weight Buffer
+__global__ void _accumulate(const soil::buffer_t<int> graph, const soil::buffer_t<float> weights, soil::buffer_t<float> out, soil::flat_t<2> index, const size_t seed, const size_t iteration, const size_t K, const size_t N, const bool reservoir){
 
-    auto [ind, w] = sample_uniform(k, index, randStates);
-    int next = graph[ind];
-    const float val = weights[ind];
-    atomicAdd(&(out[ind]), w*val/float(N));
+  const int k = blockIdx.x * blockDim.x + threadIdx.x;
+  if(k >= K) return;
 
-    while(ind != next){
-      ind = next;
-      next = graph[ind];
-      atomicAdd(&(out[ind]), w*val/float(N));
-    }
-  }
+  soil::rand_t rand(seed, iteration, k);
+  accumulate(graph, weights, out, index, rand, N, reservoir);
 
 }
 
@@ -382,13 +718,10 @@ soil::buffer soil::accumulation(const soil::buffer& direction, const soil::index
   auto out = soil::buffer_t<float>{elem, soil::GPU};
   _fill<<<block(elem, 256), 256>>>(out, 0.0f);
 
-  soil::buffer_t<curandState> randStates(samples, soil::host_t::GPU);
-  seed<<<block(samples, 512), 512>>>(randStates, 0, 0);
-
   const size_t N = iterations*samples;
   
   for(int n = 0; n < iterations; ++n){
-    _accumulate<<<block(samples, 512), 512>>>(graph_buf, out, index_t, randStates, samples, N);
+    _accumulate<<<block(samples, 512), 512>>>(graph_buf, out, index_t, 0, n, samples, N);
   }
 
   cudaDeviceSynchronize();
@@ -427,13 +760,10 @@ soil::buffer soil::accumulation(const soil::buffer& direction, const soil::buffe
   auto out = soil::buffer_t<float>{elem, soil::GPU};
   _fill<<<block(elem, 256), 256>>>(out, 0.0f);
 
-  soil::buffer_t<curandState> randStates(samples, soil::host_t::GPU);
-  seed<<<block(samples, 512), 512>>>(randStates, 0, 0);
-
   const size_t N = iterations*samples;
   
   for(int n = 0; n < iterations; ++n){
-    _accumulate<<<block(samples, 512), 512>>>(graph_buf, weight_t, out, index_t, randStates, samples, N, reservoir);
+    _accumulate<<<block(samples, 512), 512>>>(graph_buf, weight_t, out, index_t, 0, n, samples, N, reservoir);
   }
 
   cudaDeviceSynchronize();
@@ -442,6 +772,53 @@ soil::buffer soil::accumulation(const soil::buffer& direction, const soil::buffe
 
 }
 
+soil::buffer soil::accumulation(const soil::flow_graph& graph, int iterations, size_t samples){
+
+  const size_t elem = graph.index.elem();
+  const size_t N = iterations*samples;
+
+  auto out = soil::buffer_t<float>{elem, soil::CPU};
+  soil::parallel_for(elem, [&](const size_t ind){
+    out[ind] = 0.0f;
+  });
+
+  for(int n = 0; n < iterations; ++n){
+    soil::parallel_for(samples, [&](const size_t k){
+      soil::rand_t rand(0, n, k);
+      accumulate(graph.next, out, graph.index, rand, N);
+    }, 256);
+  }
+
+  return std::move(soil::buffer(std::move(out)));
+
+}
+
+soil::buffer soil::accumulation(const soil::flow_graph& graph, const soil::buffer& weights, int iterations, size_t samples, bool reservoir){
+
+  soil::select(weights.type(), [&]<std::same_as<float> W>(){});
+
+  auto weight_t = weights.as<float>();
+  weight_t.to_cpu();
+
+  const size_t elem = graph.index.elem();
+  const size_t N = iterations*samples;
+
+  auto out = soil::buffer_t<float>{elem, soil::CPU};
+  soil::parallel_for(elem, [&](const size_t ind){
+    out[ind] = 0.0f;
+  });
+
+  for(int n = 0; n < iterations; ++n){
+    soil::parallel_for(samples, [&](const size_t k){
+      soil::rand_t rand(0, n, k);
+      accumulate(graph.next, weight_t, out, graph.index, rand, N, reservoir);
+    }, 256);
+  }
+
+  return std::move(soil::buffer(std::move(out)));
+
+}
+
 //
 // Exhaustive Accumulation Kernels
 //
@@ -481,6 +858,63 @@ __global__ void _accumulate_exhaustive(const soil::buffer_t<int> graph, const so
 
 }
 
+//! Topological Accumulation:
+//!
+//!   The wavefronts of the flow graph are visited in order, and the
+//!   accumulated value of every cell is pulled from its donors, which
+//!   are all complete. Each cell is visited once, so the total work is
+//!   O(N). Since the donors are summed in their sorted order, the result
+//!   does not depend on the number of threads. Cells on a cycle are zero.
+//!
+template<typename F>
+soil::buffer_t<float> accumulate_topological(const soil::flow_graph& graph, F weight){
+
+  const size_t elem = graph.index.elem();
+  std::vector<double> acc(elem, 0.0);
+
+  for(size_t l = 0; l + 1 < graph.levels.elem(); ++l){
+    const int begin = graph.levels[l];
+    const int end = graph.levels[l + 1];
+    soil::parallel_for(end - begin, [&](const size_t f){
+      const int ind = graph.order[begin + f];
+      double sum = weight(ind);
+      for(int o = graph.offset[ind]; o < graph.offset[ind + 1]; ++o)
+        sum += acc[graph.donors[o]];
+      acc[ind] = sum;
+    }, 1024);
+  }
+
+  soil::buffer_t<float> out(elem, soil::CPU);
+  soil::parallel_for(elem, [&](const size_t ind){
+    out[ind] = float(acc[ind]);
+  });
+  return out;
+
+}
+
+soil::buffer soil::accumulation_exhaustive(const soil::flow_graph& graph){
+
+  auto out = accumulate_topological(graph, [](const int){
+    return 1.0;
+  });
+  return std::move(soil::buffer(std::move(out)));
+
+}
+
+soil::buffer soil::accumulation_exhaustive(const soil::flow_graph& graph, const soil::buffer& weights){
+
+  soil::select(weights.type(), [&]<std::same_as<float> W>(){});
+
+  auto weight_t = weights.as<float>();
+  weight_t.to_cpu();
+
+  auto out = accumulate_topological(graph, [&weight_t](const int ind){
+    return double(weight_t[ind]);
+  });
+  return std::move(soil::buffer(std::move(out)));
+
+}
+
 soil::buffer soil::accumulation_exhaustive(const soil::buffer& direction, const soil::index& index){
 
   soil::select(index.type(), [&]<std::same_as<soil::flat_t<2>> I>(){});
@@ -493,7 +927,10 @@ soil::buffer soil::accumulation_exhaustive(const soil::buffer& direction, const
   const size_t elem = index.elem();
 
   auto buffer_t = direction.as<T>();
-  buffer_t.to_gpu();
+
+  if(buffer_t.host() == soil::CPU){
+    return soil::accumulation_exhaustive(soil::flow_graph(direction, index));
+  }
 
   auto graph_buf = soil::buffer_t<int>{elem, soil::GPU};
   _graph<<<block(elem, 512), 512>>>(buffer_t, graph_buf, index_t);
@@ -526,9 +963,12 @@ soil::buffer soil::accumulation_exhaustive(const soil::buffer& direction, const
   const size_t elem = index.elem();
 
   auto buffer_t = direction.as<T>();
-  buffer_t.to_gpu();
-
   auto weight_t = weights.as<W>();
+
+  if(buffer_t.host() == soil::CPU){
+    return soil::accumulation_exhaustive(soil::flow_graph(direction, index), weights);
+  }
+
   weight_t.to_gpu();
 
   // 
@@ -551,12 +991,13 @@ soil::buffer soil::accumulation_exhaustive(const soil::buffer& direction, const
 // Upstream Mask Kernel Implementation
 //
 
-__global__ void _upstream(const soil::buffer_t<int> _next, soil::buffer_t<int> out, const size_t target, soil::flat_t<2> index, const size_t N){
+__global__ void _upstream(const soil::buffer_t<int> _next, soil::buffer_t<int> out, const size_t target, soil::flat_t<2> index, const soil::tiled_t<2> tiles){
 
   const int n = blockIdx.x * blockDim.x + threadIdx.x;
-  if(n >= N) return;
+  if(n >= tiles.elem()) return;
 
-  soil::ivec2 pos = tile_unflatten(n, index[0], index[1]);
+  const soil::ivec2 pos = tiles.unflatten(n);
+  if(index.oob(pos)) return; // Note: Tile Padding
   size_t ind = index.flatten(pos);
   const size_t ind0 = ind;
 
@@ -608,7 +1049,8 @@ soil::buffer soil::upstream(const soil::buffer& buffer, const soil::index& index
       _fill<<<block(elem, 256), 256>>>(out, 0);
 
       if(!index_t.oob(target)){
-        _upstream<<<block(elem, 512), 512>>>(graph_buf_a, out, target_index, index_t, elem);
+        const soil::tiled_t<2> tiles(index_t.ext(), soil::ivec2(8));
+        _upstream<<<block(tiles.elem(), 512), 512>>>(graph_buf_a, out, target_index, index_t, tiles);
       }
       cudaDeviceSynchronize();
 
@@ -620,21 +1062,54 @@ soil::buffer soil::upstream(const soil::buffer& buffer, const soil::index& index
 
 }
 
+//! Upstream Catchment Mask from a Flow Graph:
+//!   Breadth-first search over the donors of the target,
+//!   so that the cost is proportional to the catchment size.
+soil::buffer soil::upstream(const soil::flow_graph& graph, const glm::ivec2 target){
+
+  const size_t elem = graph.index.elem();
+  auto out = soil::buffer_t<int>{elem, soil::CPU};
+  soil::parallel_for(elem, [&](const size_t ind){
+    out[ind] = 0;
+  });
+
+  if(graph.index.oob(target))
+    return std::move(soil::buffer(std::move(out)));
+
+  const int target_index = graph.index.flatten(target);
+  std::vector<int> queue{target_index};
+  for(size_t q = 0; q < queue.size(); ++q){
+    const int ind = queue[q];
+    for(int o = graph.offset[ind]; o < graph.offset[ind + 1]; ++o){
+      const int donor = graph.donors[o];
+      if(out[donor] == 1 || donor == target_index)
+        continue; // Note: Cycles
+      out[donor] = 1;
+      queue.push_back(donor);
+    }
+  }
+
+  return std::move(soil::buffer(std::move(out)));
+
+}
+
 //
 // Upstream Distance Kernel Implementation
 //
 
-__global__ void _distance(soil::buffer_t<int> _next, soil::buffer_t<int> out, const size_t target, soil::flat_t<2> index, const size_t N){
+__global__ void _distance(soil::buffer_t<int> _next, soil::buffer_t<int> out, const size_t target, soil::flat_t<2> index, const soil::tiled_t<2> tiles){
 
   const int n = blockIdx.x * blockDim.x + threadIdx.x;
-  if(n >= N) return;
+  if(n >= tiles.elem()) return;
 
-  soil::ivec2 pos = tile_unflatten(n, index[0], index[1]);
+  const soil::ivec2 pos = tiles.unflatten(n);
+  if(index.oob(pos)) return; // Note: Tile Padding
   size_t ind = index.flatten(pos);
   const size_t ind0 = ind;
 
   // note: upper bound is absolute worst-case scenario
-  for(int step = 0; step < N; ++step){
+  const size_t N = index.elem();
+  for(size_t step = 0; step < N; ++step){
 
     if(ind == target){
       out[ind0] = step;
@@ -681,7 +1156,8 @@ soil::buffer soil::distance(const soil::buffer& buffer, const soil::index& index
 
       _fill<<<block(elem, 256), 256>>>(out, -1); // unknown state...
       if(!index_t.oob(target)){
-        _distance<<<block(elem, 512), 512>>>(graph_buf_a, out, target_index, index_t, elem);
+        const soil::tiled_t<2> tiles(index_t.ext(), soil::ivec2(8));
+        _distance<<<block(tiles.elem(), 512), 512>>>(graph_buf_a, out, target_index, index_t, tiles);
       }
       cudaDeviceSynchronize();
 
@@ -692,5 +1168,96 @@ soil::buffer soil::distance(const soil::buffer& buffer, const soil::index& index
 
 }
 
+//! Upstream Distance from a Flow Graph:
+//!   Breadth-first search over the donors of the target, where the
+//!   distance is the number of steps along the flow path to the target.
+soil::buffer soil::distance(const soil::flow_graph& graph, const glm::ivec2 target){
+
+  const size_t elem = graph.index.elem();
+  auto out = soil::buffer_t<int>{elem, soil::CPU};
+  soil::parallel_for(elem, [&](const size_t ind){
+    out[ind] = -1;
+  });
+
+  if(graph.index.oob(target))
+    return std::move(soil::buffer(std::move(out)));
+
+  std::vector<int> queue{int(graph.index.flatten(target))};
+  out[queue[0]] = 0;
+  for(size_t q = 0; q < queue.size(); ++q){
+    const int ind = queue[q];
+    for(int o = graph.offset[ind]; o < graph.offset[ind + 1]; ++o){
+      const int donor = graph.donors[o];
+      if(out[donor] >= 0)
+        continue; // Note: Cycles
+      out[donor] = out[ind] + 1;
+      queue.push_back(donor);
+    }
+  }
+
+  return std::move(soil::buffer(std::move(out)));
+
+}
+
+//
+// Batched Catchment Implementation
+//
+
+std::pair<soil::buffer, soil::buffer> soil::catchments(const soil::flow_graph& graph, const std::vector<glm::ivec2>& targets){
+
+  const size_t elem = graph.index.elem();
+  auto label = soil::buffer_t<int>{elem, soil::CPU};
+  auto dist = soil::buffer_t<int>{elem, soil::CPU};
+  soil::parallel_for(elem, [&](const size_t ind){
+    label[ind] = -1;
+    dist[ind] = -1;
+  });
+
+  // Label Outlets First, so that nested Catchments
+  //  are assigned to their nearest downstream Outlet
+
+  std::vector<int> outlets(targets.size(), -1);
+  for(size_t k = 0; k < targets.size(); ++k){
+    if(graph.index.oob(targets[k]))
+      continue;
+    const int ind = graph.index.flatten(targets[k]);
+    if(label[ind] >= 0)
+      continue; // Note: Duplicate Outlet
+    label[ind] = k;
+    dist[ind] = 0;
+    outlets[k] = ind;
+  }
+
+  // Breadth-First Search per Outlet: The catchments are disjoint,
+  //  so that every outlet can be searched on a separate thread.
+
+  soil::parallel_for(targets.size(), [&](const size_t k){
+
+    if(outlets[k] < 0)
+      return;
+
+    std::vector<int> queue{outlets[k]};
+    for(size_t q = 0; q < queue.size(); ++q){
+      const int ind = queue[q];
+      for(int o = graph.offset[ind]; o < graph.offset[ind + 1]; ++o){
+        const int donor = graph.donors[o];
+        if(label[donor] >= 0)
+          continue; // Note: Nested Outlets, Cycles
+        label[donor] = k;
+        dist[donor] = dist[ind] + 1;
+        queue.push_back(donor);
+      }
+    }
+
+  }, 1);
+
+  return {soil::buffer(std::move(label)), soil::buffer(std::move(dist))};
+
+}
+
+std::pair<soil::buffer, soil::buffer> soil::catchments(const soil::buffer& direction, const soil::index& index, const std::vector<glm::ivec2>& targets){
+  return soil::catchments(soil::flow_graph(direction, index), targets);
+}
+
 // note: move this to a different file
 #endif
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define SOILLIB_LAYER_FLOW
 
 #include <random>
+#include <utility>
+#include <vector>
 #include <soillib/core/buffer.hpp>
 #include <soillib/core/index.hpp>
 #include <soillib/soillib.hpp>
@@ -48,11 +50,51 @@ const std::vector<double> dist = {
 
 } // namespace
 
+//! flow_graph is the drainage network of a 2D flow direction buffer,
+//! which is built once on the host and shared between flow queries.
+//!
+//! The graph stores the successor of every cell, the donors of every
+//! cell as a compressed sparse row list and a topological order, where
+//! every cell comes after all of its donors. The order is partitioned
+//! into wavefronts, whose cells only depend on previous wavefronts.
+//!
+//! Note: The graph requires a flat_t<2> index. Buffers with a tiled
+//! layout have to be reordered to a flat layout first, which also holds
+//! for the accumulation, upstream, distance and catchment operations.
+//!
+//! Usage:
+//!
+//! soil::flow_graph graph(direction, index);
+//! soil::buffer area = soil::accumulation_exhaustive(graph);
+//! soil::buffer mask = soil::upstream(graph, target);
+//!
+struct flow_graph {
+
+  flow_graph() = default;
+  flow_graph(const soil::buffer &direction, const soil::index &index);
+
+  soil::flat_t<2> index;       //!< Index of the Direction Buffer
+  soil::buffer_t<int> next;    //!< Successor Index (or Self for Outlets)
+  soil::buffer_t<int> offset;  //!< Donor Range of Cell i: [offset[i], offset[i+1])
+  soil::buffer_t<int> donors;  //!< Donor Indices, Sorted per Range
+  soil::buffer_t<int> order;   //!< Topological Order (Donors First)
+  soil::buffer_t<int> levels;  //!< Wavefront Range l: [levels[l], levels[l+1]) of order
+};
+
 //! Compute the Indexed Flow Direction from a Height-Map
 //! The flow directions are given by dirmap(7, 8, 1, 2, 3, 4, 5, 6),
 //! corresponding to (N, NE, E, SE, S, SW, W, NW)
+//! Accepts flat and tiled layouts; tile padding is marked as a pit (-2).
 soil::buffer flow(const soil::buffer &buffer, const soil::index &index);
 
+//! Condition a Height-Map for Drainage (Priority-Flood + Epsilon)
+//! Depressions are filled and flats are given a minimal gradient towards
+//! their spill point, so that every cell drains to the domain boundary or
+//! to a no-data (NaN) cell. Raised cells are lifted by epsilon, or by one
+//! unit in the last place if epsilon is zero. The result is on the CPU.
+//! Accepts flat and tiled layouts; tile padding is set to no-data (NaN).
+soil::buffer condition(const soil::buffer &buffer, const soil::index &index, const double epsilon = 0.0);
+
 //! Compute the 2D Flow Direction from the Flow Index Buffer
 soil::buffer direction(const soil::buffer &buffer, const soil::index &index);
 
@@ -63,6 +105,9 @@ soil::buffer accumulation(const soil::buffer &buffer, const soil::index &index,
 soil::buffer accumulation(const soil::buffer &direction, const soil::buffer &weights, const soil::index &index, int iterations, size_t samplesm, bool reservoir = true);
 
 //! Compute the Exhaustive Accumulation from a 2D Flow Direction Buffer
+//! Buffers on the CPU are accumulated in topological order in O(N),
+//! through a flow_graph (see below), with a result which is independent
+//! of the number of host threads.
 soil::buffer accumulation_exhaustive(const soil::buffer &direction, const soil::index &index);
 
 //! Compute the Exhaustive Accumulation from a 2D Flow Direction Buffer
@@ -74,6 +119,36 @@ soil::buffer upstream(const soil::buffer &buffer, const soil::index &index, cons
 //! Compute the Upstream Distance from a Flow Direction Buffer for a given Position
 soil::buffer distance(const soil::buffer &buffer, const soil::index &index, const glm::ivec2 target);
 
+// Flow Graph Queries (Host)
+
+//! Compute the Stochastic Accumulation from a Flow Graph
+soil::buffer accumulation(const soil::flow_graph &graph, int iterations, size_t samples);
+
+//! Compute the Weighted Stochastic Accumulation from a Flow Graph
+soil::buffer accumulation(const soil::flow_graph &graph, const soil::buffer &weights, int iterations, size_t samples, bool reservoir = true);
+
+//! Compute the Exhaustive Accumulation from a Flow Graph in Topological Order
+soil::buffer accumulation_exhaustive(const soil::flow_graph &graph);
+
+//! Compute the Weighted Exhaustive Accumulation from a Flow Graph in Topological Order
+soil::buffer accumulation_exhaustive(const soil::flow_graph &graph, const soil::buffer &weights);
+
+//! Compute an Upstream Catchment Mask from a Flow Graph for a given Position
+soil::buffer upstream(const soil::flow_graph &graph, const glm::ivec2 target);
+
+//! Compute the Upstream Distance (Steps) from a Flow Graph for a given Position
+soil::buffer distance(const soil::flow_graph &graph, const glm::ivec2 target);
+
+//! Compute the Upstream Catchments of a Set of Outlets in a Single Pass
+//! Returns a label buffer, with the index of the outlet whose catchment
+//! contains the cell (or -1), and a distance buffer with the number of
+//! steps to that outlet (or -1). Nested catchments are assigned to their
+//! nearest downstream outlet. The cost is proportional to the catchments.
+std::pair<soil::buffer, soil::buffer> catchments(const soil::flow_graph &graph, const std::vector<glm::ivec2> &targets);
+
+//! Compute the Upstream Catchments of a Set of Outlets from a Flow Direction Buffer
+std::pair<soil::buffer, soil::buffer> catchments(const soil::buffer &direction, const soil::index &index, const std::vector<glm::ivec2> &targets);
+
 } // end of namespace soil
 
 #endif
\ No newline at end of file
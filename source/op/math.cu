@@ -56,6 +56,62 @@ template soil::buffer_t<vec2>   resample_impl<vec2>  (const soil::buffer_t<vec2>
 template soil::buffer_t<vec3>   resample_impl<vec3>  (const soil::buffer_t<vec3>& buffer,   const soil::index& index);
 template soil::buffer_t<ivec2>  resample_impl<ivec2> (const soil::buffer_t<ivec2>& buffer,  const soil::index& index);
 template soil::buffer_t<ivec3>  resample_impl<ivec3> (const soil::buffer_t<ivec3>& buffer,  const soil::index& index);
+template soil::buffer_t<uint8_t>  resample_impl<uint8_t>  (const soil::buffer_t<uint8_t>& buffer,  const soil::index& index);
+template soil::buffer_t<int16_t>  resample_impl<int16_t>  (const soil::buffer_t<int16_t>& buffer,  const soil::index& index);
+template soil::buffer_t<uint16_t> resample_impl<uint16_t> (const soil::buffer_t<uint16_t>& buffer, const soil::index& index);
+template soil::buffer_t<half>     resample_impl<half>     (const soil::buffer_t<half>& buffer,     const soil::index& index);
+
+//
+// Reorder Kernels
+//
+
+template<typename T, typename Index, typename Flat>
+__global__ void _reorder(const soil::buffer_t<T> input, soil::buffer_t<T> output, const Index index, const Flat flat){
+  const unsigned int n = blockIdx.x * blockDim.x + threadIdx.x;
+  if(n >= flat.elem()) return;
+
+  auto pos = flat.unflatten(n);
+  output[index.flatten(pos + index.min())] = input[n];
+}
+
+template<typename T>
+soil::buffer_t<T> reorder_impl(const soil::buffer_t<T>& input, const soil::index& index){
+
+  return select(index.type(), [&]<typename I>(){
+
+    auto index_t = index.as<I>();
+    soil::flat_t<I::n_dims> flat(index_t.ext());
+
+    if(input.elem() != flat.elem())
+      throw soil::error::mismatch_size(flat.elem(), input.elem());
+
+    soil::buffer_t<T> output(index_t.elem(), soil::GPU);
+    using V = soil::typedesc<T>::value_t;
+    T value = T{std::numeric_limits<V>::quiet_NaN()};
+    set_impl<T>(output, value, 0, index_t.elem(), 1);
+
+    int thread = 1024;
+    int elem = flat.elem();
+    int block = (elem + thread - 1)/thread;
+    _reorder<<<block, thread>>>(input, output, index_t, flat);
+
+    return output;
+
+  });
+
+}
+
+template soil::buffer_t<int>    reorder_impl<int>   (const soil::buffer_t<int>& buffer,    const soil::index& index);
+template soil::buffer_t<float>  reorder_impl<float> (const soil::buffer_t<float>& buffer,  const soil::index& index);
+template soil::buffer_t<double> reorder_impl<double>(const soil::buffer_t<double>& buffer, const soil::index& index);
+template soil::buffer_t<vec2>   reorder_impl<vec2>  (const soil::buffer_t<vec2>& buffer,   const soil::index& index);
+template soil::buffer_t<vec3>   reorder_impl<vec3>  (const soil::buffer_t<vec3>& buffer,   const soil::index& index);
+template soil::buffer_t<ivec2>  reorder_impl<ivec2> (const soil::buffer_t<ivec2>& buffer,  const soil::index& index);
+template soil::buffer_t<ivec3>  reorder_impl<ivec3> (const soil::buffer_t<ivec3>& buffer,  const soil::index& index);
+template soil::buffer_t<uint8_t>  reorder_impl<uint8_t>  (const soil::buffer_t<uint8_t>& buffer,  const soil::index& index);
+template soil::buffer_t<int16_t>  reorder_impl<int16_t>  (const soil::buffer_t<int16_t>& buffer,  const soil::index& index);
+template soil::buffer_t<uint16_t> reorder_impl<uint16_t> (const soil::buffer_t<uint16_t>& buffer, const soil::index& index);
+template soil::buffer_t<half>     reorder_impl<half>     (const soil::buffer_t<half>& buffer,     const soil::index& index);
 
 //
 // Addition Kernels
@@ -98,6 +154,10 @@ template void add_impl<vec2>  (soil::buffer_t<vec2> buffer,   const vec2 val);
 template void add_impl<vec3>  (soil::buffer_t<vec3> buffer,   const vec3 val);
 template void add_impl<ivec2> (soil::buffer_t<ivec2> buffer,  const ivec2 val);
 template void add_impl<ivec3> (soil::buffer_t<ivec3> buffer,  const ivec3 val);
+template void add_impl<uint8_t>  (soil::buffer_t<uint8_t> buffer,  const uint8_t val);
+template void add_impl<int16_t>  (soil::buffer_t<int16_t> buffer,  const int16_t val);
+template void add_impl<uint16_t> (soil::buffer_t<uint16_t> buffer, const uint16_t val);
+template void add_impl<half>     (soil::buffer_t<half> buffer,     const half val);
 
 template void add_impl<int>   (soil::buffer_t<int> lhs,     const soil::buffer_t<int> rhs);
 template void add_impl<float> (soil::buffer_t<float> lhs,   const soil::buffer_t<float> rhs);
@@ -106,6 +166,10 @@ template void add_impl<vec2>  (soil::buffer_t<vec2> lhs,    const soil::buffer_t
 template void add_impl<vec3>  (soil::buffer_t<vec3> lhs,    const soil::buffer_t<vec3> rhs);
 template void add_impl<ivec2> (soil::buffer_t<ivec2> lhs,   const soil::buffer_t<ivec2> rhs);
 template void add_impl<ivec3> (soil::buffer_t<ivec3> lhs,   const soil::buffer_t<ivec3> rhs);
+template void add_impl<uint8_t>  (soil::buffer_t<uint8_t> lhs,  const soil::buffer_t<uint8_t> rhs);
+template void add_impl<int16_t>  (soil::buffer_t<int16_t> lhs,  const soil::buffer_t<int16_t> rhs);
+template void add_impl<uint16_t> (soil::buffer_t<uint16_t> lhs, const soil::buffer_t<uint16_t> rhs);
+template void add_impl<half>     (soil::buffer_t<half> lhs,     const soil::buffer_t<half> rhs);
 
 //
 // Multiplication Kernels
@@ -148,6 +212,10 @@ template void multiply_impl<vec2>  (soil::buffer_t<vec2> buffer,   const vec2 va
 template void multiply_impl<vec3>  (soil::buffer_t<vec3> buffer,   const vec3 val);
 template void multiply_impl<ivec2> (soil::buffer_t<ivec2> buffer,  const ivec2 val);
 template void multiply_impl<ivec3> (soil::buffer_t<ivec3> buffer,  const ivec3 val);
+template void multiply_impl<uint8_t>  (soil::buffer_t<uint8_t> buffer,  const uint8_t val);
+template void multiply_impl<int16_t>  (soil::buffer_t<int16_t> buffer,  const int16_t val);
+template void multiply_impl<uint16_t> (soil::buffer_t<uint16_t> buffer, const uint16_t val);
+template void multiply_impl<half>     (soil::buffer_t<half> buffer,     const half val);
 
 template void multiply_impl<int>   (soil::buffer_t<int> lhs,     const soil::buffer_t<int> rhs);
 template void multiply_impl<float> (soil::buffer_t<float> lhs,   const soil::buffer_t<float> rhs);
@@ -156,6 +224,10 @@ template void multiply_impl<vec2>  (soil::buffer_t<vec2> lhs,    const soil::buf
 template void multiply_impl<vec3>  (soil::buffer_t<vec3> lhs,    const soil::buffer_t<vec3> rhs);
 template void multiply_impl<ivec2> (soil::buffer_t<ivec2> lhs,   const soil::buffer_t<ivec2> rhs);
 template void multiply_impl<ivec3> (soil::buffer_t<ivec3> lhs,   const soil::buffer_t<ivec3> rhs);
+template void multiply_impl<uint8_t>  (soil::buffer_t<uint8_t> lhs,  const soil::buffer_t<uint8_t> rhs);
+template void multiply_impl<int16_t>  (soil::buffer_t<int16_t> lhs,  const soil::buffer_t<int16_t> rhs);
+template void multiply_impl<uint16_t> (soil::buffer_t<uint16_t> lhs, const soil::buffer_t<uint16_t> rhs);
+template void multiply_impl<half>     (soil::buffer_t<half> lhs,     const soil::buffer_t<half> rhs);
 
 /*
 //
@@ -184,6 +256,10 @@ template void invert_impl<vec2>  (soil::buffer_t<vec2> buffer);
 template void invert_impl<vec3>  (soil::buffer_t<vec3> buffer);
 template void invert_impl<ivec2> (soil::buffer_t<ivec2> buffer);
 template void invert_impl<ivec3> (soil::buffer_t<ivec3> buffer);
+template void invert_impl<uint8_t>  (soil::buffer_t<uint8_t> buffer)  ;
+template void invert_impl<int16_t>  (soil::buffer_t<int16_t> buffer)  ;
+template void invert_impl<uint16_t> (soil::buffer_t<uint16_t> buffer) ;
+template void invert_impl<half>     (soil::buffer_t<half> buffer)     ;
 */
 
 }
@@ -4,6 +4,7 @@
 #include <limits>
 #include <soillib/core/buffer.hpp>
 #include <soillib/core/index.hpp>
+#include <soillib/op/common.hpp>
 
 namespace soil {
 
@@ -91,6 +92,50 @@ soil::buffer_t<T> resample(const soil::buffer_t<T> &input, const soil::index &in
     throw std::invalid_argument("HOST NOT RECOGNIZED");
 }
 
+//
+// Reorder Buffer into Index Layout
+//
+
+template<typename T>
+soil::buffer_t<T> reorder_impl(const soil::buffer_t<T> &buffer, const soil::index &index);
+
+//! reorder is the inverse of resample: a compact, row-major buffer with
+//! the extent of the index is reordered into the layout of the index
+//! (e.g. morton_t). Padding elements of the index are set to NaN.
+template<typename T>
+soil::buffer_t<T> reorder(const soil::buffer_t<T> &input, const soil::index &index) {
+
+  if (input.host() == soil::host_t::CPU) {
+    return select(index.type(), [&]<typename I>() {
+      auto index_t = index.as<I>();
+      soil::flat_t<I::n_dims> flat(index_t.ext());
+
+      if (input.elem() != flat.elem())
+        throw soil::error::mismatch_size(flat.elem(), input.elem());
+
+      soil::buffer_t<T> output(index_t.elem());
+
+      using V = soil::typedesc<T>::value_t;
+      T value = T{std::numeric_limits<V>::quiet_NaN()};
+      set(output, value);
+
+      for (const auto &pos : index_t.iter()) {
+        const size_t i = index_t.flatten(pos);
+        output[i] = input[flat.flatten(pos - index_t.min())];
+      }
+
+      return output;
+    });
+  }
+
+  else if (input.host() == soil::host_t::GPU) {
+    return reorder_impl(input, index);
+  }
+
+  else
+    throw std::invalid_argument("HOST NOT RECOGNIZED");
+}
+
 //
 // Add Buffer from Buffer and Value In-Place
 //
@@ -102,8 +147,7 @@ template<typename T>
 void add(soil::buffer_t<T> &buffer, const T val) {
   // CPU Implementation
   if (buffer.host() == soil::host_t::CPU) {
-    for (size_t i = 0; i < buffer.elem(); ++i)
-      buffer[i] += val;
+    host_unary(buffer, val, [](const auto a, const auto b) { return a + b; });
   }
   // GPU Implementation
   else if (buffer.host() == soil::host_t::GPU) {
@@ -124,8 +168,7 @@ void add(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs) {
     throw soil::error::mismatch_host(lhs.host(), rhs.host());
 
   if (lhs.host() == soil::host_t::CPU) {
-    for (size_t i = 0; i < lhs.elem(); ++i)
-      lhs[i] += rhs[i];
+    host_binary(lhs, rhs, [](const auto a, const auto b) { return a + b; });
   }
 
   else if (lhs.host() == soil::host_t::GPU) {
@@ -144,8 +187,7 @@ template<typename T>
 void multiply(soil::buffer_t<T> &buffer, const T val) {
   // CPU Implementation
   if (buffer.host() == soil::host_t::CPU) {
-    for (size_t i = 0; i < buffer.elem(); ++i)
-      buffer[i] *= val;
+    host_unary(buffer, val, [](const auto a, const auto b) { return a * b; });
   }
   // GPU Implementation
   else if (buffer.host() == soil::host_t::GPU) {
@@ -166,8 +208,7 @@ void multiply(soil::buffer_t<T> &lhs, const soil::buffer_t<T> &rhs) {
     throw soil::error::mismatch_host(lhs.host(), rhs.host());
 
   if (lhs.host() == soil::host_t::CPU) {
-    for (size_t i = 0; i < lhs.elem(); ++i)
-      lhs[i] *= rhs[i];
+    host_binary(lhs, rhs, [](const auto a, const auto b) { return a * b; });
   }
 
   else if (lhs.host() == soil::host_t::GPU) {
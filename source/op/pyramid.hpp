@@ -0,0 +1,213 @@
+#ifndef SOILLIB_OP_PYRAMID
+#define SOILLIB_OP_PYRAMID
+
+#include <soillib/core/buffer.hpp>
+#include <soillib/core/index.hpp>
+#include <soillib/core/types.hpp>
+#include <soillib/util/error.hpp>
+#include <soillib/util/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace soil {
+
+//! pyramid is a resolution pyramid (mipmap) over a 2D buffer,
+//! for coarse-to-fine processing, previews and coarse queries.
+//!
+//! Level 0 is the (shared) input buffer, and every further level
+//! halves the extent (rounding up), down to a single cell. Each cell
+//! is the area-average of the (up to) 2x2 cells of the previous level,
+//! where NaN values are excluded, so that nodata doesn't spread.
+//! Cells without any valid values remain NaN. Vector types are
+//! reduced per component, and integer types are rounded.
+//!
+//! An optional nodata value is excluded like NaN, and is written to
+//! cells without any valid values instead, e.g. for integer types.
+//!
+//! Levels are materialized lazily when they are first requested,
+//! together with the levels in between. If the input buffer is
+//! modified, the region can be invalidated, and only the affected
+//! tiles of the materialized levels are rebuilt on the next request.
+//!
+//! Usage:
+//!
+//! soil::pyramid pyramid(buffer, index);
+//! soil::buffer preview = pyramid.level(4);
+//! ... modify buffer in [min, max) ...
+//! pyramid.invalidate(min, max);
+//! pyramid.update();
+//!
+struct pyramid {
+
+  static constexpr int tile = 64; //!< Tile Extent for Incremental Rebuilds
+
+  pyramid(const soil::buffer &buffer, const soil::index &index, const size_t levels = 0, const std::optional<double> nodata = std::nullopt);
+
+  //! Number of Levels (incl. Level 0)
+  size_t levels() const { return this->_index.size(); }
+
+  //! Index of a Level
+  soil::flat_t<2> index(const size_t level) const {
+    return this->_index.at(level);
+  }
+
+  //! Buffer of a Level, which is materialized or updated if required
+  soil::buffer level(const size_t level);
+
+  //! Mark the Region [min, max) of Level 0 as Modified
+  void invalidate(const glm::ivec2 min, const glm::ivec2 max);
+
+  //! Rebuild the Modified Tiles of all Materialized Levels
+  void update();
+
+private:
+  void build(const size_t level);
+
+  template<typename T>
+  void reduce(const size_t level, const std::vector<int> &tiles, const std::optional<double> nodata);
+
+  std::optional<double> _nodata;           //!< NoData Value (besides NaN)
+  std::vector<soil::flat_t<2>> _index;     //!< Index per Level
+  std::vector<soil::buffer> _level;        //!< Buffer per Level
+  std::vector<bool> _built;                //!< Level is Materialized
+  std::vector<std::vector<bool>> _dirty;   //!< Modified Tiles per Level
+};
+
+inline pyramid::pyramid(const soil::buffer &buffer, const soil::index &index, const size_t levels, const std::optional<double> nodata): _nodata{nodata} {
+
+  if (index.type() != soil::dindex::FLAT2)
+    throw std::invalid_argument("pyramid requires a flat 2D index");
+
+  if (buffer.host() != soil::host_t::CPU)
+    throw soil::error::mismatch_host(soil::host_t::CPU, buffer.host());
+
+  if (buffer.elem() != index.elem())
+    throw soil::error::mismatch_size(index.elem(), buffer.elem());
+
+  glm::ivec2 ext = index.as<soil::flat_t<2>>().ext();
+  this->_index.emplace_back(ext);
+  while ((levels == 0 || this->_index.size() < levels) && (ext[0] > 1 || ext[1] > 1)) {
+    ext = (ext + glm::ivec2(1)) / 2;
+    this->_index.emplace_back(ext);
+  }
+
+  this->_level.resize(this->levels());
+  this->_level[0] = buffer;
+  this->_built.assign(this->levels(), false);
+  this->_built[0] = true;
+  this->_dirty.resize(this->levels());
+}
+
+inline soil::buffer pyramid::level(const size_t level) {
+  if (level >= this->levels())
+    throw std::out_of_range("pyramid level out of range");
+  for (size_t l = 1; l <= level; ++l)
+    this->build(l);
+  return this->_level[level];
+}
+
+inline void pyramid::invalidate(const glm::ivec2 min, const glm::ivec2 max) {
+  for (size_t l = 1; l < this->levels(); ++l) {
+    if (!this->_built[l])
+      continue;
+    const glm::ivec2 ext = this->_index[l].ext();
+    const glm::ivec2 tiles = (ext + glm::ivec2(tile - 1)) / tile;
+    const int scale = 1 << l;
+    const glm::ivec2 lmin = glm::max(min, glm::ivec2(0)) / scale;
+    const glm::ivec2 lmax = glm::min((glm::max(max, glm::ivec2(0)) + glm::ivec2(scale - 1)) / scale, ext);
+    for (int x = lmin[0] / tile; x * tile < lmax[0]; ++x)
+      for (int y = lmin[1] / tile; y * tile < lmax[1]; ++y)
+        this->_dirty[l][x * tiles[1] + y] = true;
+  }
+}
+
+inline void pyramid::update() {
+  for (size_t l = 1; l < this->levels() && this->_built[l]; ++l)
+    this->build(l);
+}
+
+inline void pyramid::build(const size_t level) {
+
+  const glm::ivec2 ext = this->_index[level].ext();
+  const glm::ivec2 tiles = (ext + glm::ivec2(tile - 1)) / tile;
+
+  if (!this->_built[level]) {
+    this->_level[level] = soil::buffer(this->_level[0].type(), this->_index[level].elem());
+    this->_dirty[level].assign(size_t(tiles[0]) * size_t(tiles[1]), true);
+    this->_built[level] = true;
+  }
+
+  std::vector<int> dirty;
+  for (size_t t = 0; t < this->_dirty[level].size(); ++t)
+    if (this->_dirty[level][t])
+      dirty.push_back(t);
+
+  if (dirty.empty())
+    return;
+
+  soil::select(this->_level[0].type(), [&]<typename T>() {
+    this->reduce<T>(level, dirty, this->_nodata);
+  });
+
+  for (const int t : dirty)
+    this->_dirty[level][t] = false;
+}
+
+template<typename T>
+void pyramid::reduce(const size_t level, const std::vector<int> &tiles, const std::optional<double> nodata) {
+
+  using V = typename soil::typedesc<T>::value_t;
+  constexpr size_t N = sizeof(T) / sizeof(V);
+
+  // Note: The NoData Value is compared in the Value Type
+  const double skip = nodata ? double(V(*nodata)) : std::numeric_limits<double>::quiet_NaN();
+  const V empty = nodata ? V(*nodata) : std::numeric_limits<V>::quiet_NaN();
+
+  const soil::flat_t<2> src_index = this->_index[level - 1];
+  const soil::flat_t<2> dst_index = this->_index[level];
+  const glm::ivec2 src_ext = src_index.ext();
+  const glm::ivec2 dst_ext = dst_index.ext();
+  const int n_tiles = (dst_ext[1] + tile - 1) / tile;
+
+  const V *src = reinterpret_cast<const V *>(this->_level[level - 1].as<T>().data());
+  V *dst = reinterpret_cast<V *>(this->_level[level].as<T>().data());
+
+  soil::parallel_for(tiles.size(), [&](const size_t k) {
+    const glm::ivec2 tmin = tile * glm::ivec2(tiles[k] / n_tiles, tiles[k] % n_tiles);
+    const glm::ivec2 tmax = glm::min(tmin + glm::ivec2(tile), dst_ext);
+
+    for (int x = tmin[0]; x < tmax[0]; ++x) {
+      for (int y = tmin[1]; y < tmax[1]; ++y) {
+        for (size_t n = 0; n < N; ++n) {
+          double sum = 0.0;
+          int count = 0;
+          for (int sx = 2 * x; sx < std::min(2 * x + 2, src_ext[0]); ++sx) {
+            for (int sy = 2 * y; sy < std::min(2 * y + 2, src_ext[1]); ++sy) {
+              const double v = double(src[src_index.flatten({sx, sy}) * N + n]);
+              if (v == v && v != skip) {
+                sum += v;
+                ++count;
+              }
+            }
+          }
+          V &out = dst[dst_index.flatten({x, y}) * N + n];
+          if (count == 0)
+            out = empty;
+          else if constexpr (std::is_integral_v<V>)
+            out = V(std::round(sum / count));
+          else
+            out = V(sum / count);
+        }
+      }
+    }
+  }, 1);
+}
+
+} // end of namespace soil
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SOILLIB_UTIL_ATOMIC
+#define SOILLIB_UTIL_ATOMIC
+
+#include <soillib/soillib.hpp>
+
+#include <atomic>
+
+namespace soil {
+
+//! atomic_add is a device-agnostic atomic addition,
+//! which maps to atomicAdd when compiled for the GPU
+//! and to an atomic reference on the host.
+//!
+//! This lets kernel bodies which scatter values into
+//! a shared buffer be executed on the host thread pool.
+//!
+template<typename T>
+GPU_ENABLE inline void atomic_add(T *address, const T value) {
+#ifdef __CUDA_ARCH__
+  atomicAdd(address, value);
+#else
+  std::atomic_ref<T>(*address).fetch_add(value, std::memory_order_relaxed);
+#endif
+}
+
+} // end of namespace soil
+
+#endif
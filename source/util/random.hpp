@@ -0,0 +1,99 @@
+#ifndef SOILLIB_UTIL_RANDOM
+#define SOILLIB_UTIL_RANDOM
+
+#include <soillib/soillib.hpp>
+
+#include <cstdint>
+
+namespace soil {
+
+//! philox is a stateless, counter-based random number generator
+//! (Philox4x32-10, Salmon et al. 2011). A 128-bit counter and a
+//! 64-bit key are mapped to four independent 32-bit values.
+//!
+//! Since no state is stored, values are reproducible from their
+//! key and counter alone and are bit-identical on CPU and GPU.
+//!
+struct philox {
+
+  struct uint4_t {
+    uint32_t x, y, z, w;
+  };
+
+  GPU_ENABLE static uint4_t generate(uint4_t ctr, uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < 10; ++r) {
+      if (r > 0) {
+        k0 += W0;
+        k1 += W1;
+      }
+      const uint64_t p0 = uint64_t(M0) * uint64_t(ctr.x);
+      const uint64_t p1 = uint64_t(M1) * uint64_t(ctr.z);
+      ctr = uint4_t{
+          uint32_t(p1 >> 32) ^ ctr.y ^ k0,
+          uint32_t(p1),
+          uint32_t(p0 >> 32) ^ ctr.w ^ k1,
+          uint32_t(p0)
+      };
+    }
+    return ctr;
+  }
+
+private:
+  static constexpr uint32_t M0 = 0xD2511F53;
+  static constexpr uint32_t M1 = 0xCD9E8D57;
+  static constexpr uint32_t W0 = 0x9E3779B9;
+  static constexpr uint32_t W1 = 0xBB67AE85;
+};
+
+//! rand_t is a lightweight sequence of draws from the philox
+//! generator, keyed by (seed, step, sample, stream).
+//!
+//! The n-th draw of a sequence is a pure function of the key,
+//! so that samples can be distributed arbitrarily over threads,
+//! kernels and devices without changing the generated values.
+//!
+//! Usage:
+//!
+//! soil::rand_t rand(seed, step, sample);
+//! float u = rand.uniform(); // [0, 1)
+//!
+struct rand_t {
+
+  GPU_ENABLE rand_t(const uint64_t seed, const uint32_t step, const uint32_t sample, const uint32_t stream = 0):
+      k0{uint32_t(seed)}, k1{uint32_t(seed >> 32)}, step{step}, sample{sample}, stream{stream} {}
+
+  //! Next Raw 32-Bit Value
+  GPU_ENABLE uint32_t next() {
+    const uint32_t lane = this->draw % 4;
+    if (lane == 0)
+      this->block = philox::generate({this->sample, this->step, this->draw / 4, this->stream}, this->k0, this->k1);
+    ++this->draw;
+    switch (lane) {
+    case 0:
+      return this->block.x;
+    case 1:
+      return this->block.y;
+    case 2:
+      return this->block.z;
+    default:
+      return this->block.w;
+    }
+  }
+
+  //! Next Uniform Value in [0, 1)
+  GPU_ENABLE float uniform() {
+    return float(this->next() >> 8) * (1.0f / 16777216.0f);
+  }
+
+private:
+  uint32_t k0, k1;         //!< Generator Key (Seed)
+  uint32_t step;           //!< Counter: Step / Iteration
+  uint32_t sample;         //!< Counter: Sample Index
+  uint32_t stream;         //!< Counter: Independent Stream
+  uint32_t draw = 0;       //!< Number of Values Drawn
+  philox::uint4_t block{}; //!< Cached Generator Output
+};
+
+} // end of namespace soil
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef SOILLIB_UTIL_RANGE
+#define SOILLIB_UTIL_RANGE
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace soil {
+
+//! range_t is a random-access, allocation-free range over [0, size),
+//! whose elements are computed from their flat index by a functor.
+//!
+//! Unlike yield, a range has no coroutine frame to allocate and its
+//! iterator is a plain (functor, index) pair, so that loops over it
+//! can be inlined and vectorized. The functor is copied into every
+//! iterator and should therefore be small (e.g. a pointer or extent).
+//!
+//! Ranges of tuples can be unpacked in range based for loops:
+//!
+//! for(auto [index, value]: buffer.const_iter())
+//!   std::print(index, value);
+//!
+template<typename F>
+struct range_t {
+
+  typedef std::invoke_result_t<const F &, size_t> value_type;
+
+  struct iterator {
+
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = range_t::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+    using pointer = void;
+
+    iterator() = default;
+    iterator(const F &func, const size_t index): func{func},
+                                                 index{index} {}
+
+    value_type operator*() const { return func(index); }
+    value_type operator[](const difference_type n) const { return func(index + n); }
+
+    iterator &operator++() {
+      ++index;
+      return *this;
+    }
+    iterator &operator--() {
+      --index;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator it = *this;
+      ++index;
+      return it;
+    }
+    iterator operator--(int) {
+      iterator it = *this;
+      --index;
+      return it;
+    }
+
+    iterator &operator+=(const difference_type n) {
+      index += n;
+      return *this;
+    }
+    iterator &operator-=(const difference_type n) {
+      index -= n;
+      return *this;
+    }
+
+    friend iterator operator+(iterator it, const difference_type n) { return it += n; }
+    friend iterator operator+(const difference_type n, iterator it) { return it += n; }
+    friend iterator operator-(iterator it, const difference_type n) { return it -= n; }
+    friend difference_type operator-(const iterator &lhs, const iterator &rhs) {
+      return difference_type(lhs.index) - difference_type(rhs.index);
+    }
+
+    friend bool operator==(const iterator &lhs, const iterator &rhs) { return lhs.index == rhs.index; }
+    friend auto operator<=>(const iterator &lhs, const iterator &rhs) { return lhs.index <=> rhs.index; }
+
+  private:
+    F func;
+    size_t index = 0;
+  };
+
+  range_t(const F func, const size_t size): func{func},
+                                            _size{size} {}
+
+  iterator begin() const { return iterator(func, 0); }
+  iterator end() const { return iterator(func, _size); }
+
+  size_t size() const { return this->_size; }
+  value_type operator[](const size_t index) const { return func(index); }
+
+private:
+  F func;
+  size_t _size;
+};
+
+//! unflatten_t is a range functor, which maps flat indices
+//! to positions through the unflatten method of an index.
+//!
+//! The index is stored by value, so that the range remains valid
+//! after a temporary index is destroyed. For indices which own their
+//! data, I can be a pointer type, in which case it is dereferenced.
+//!
+template<typename I>
+struct unflatten_t {
+  I index;
+  auto operator()(const size_t i) const {
+    if constexpr (std::is_pointer_v<I>)
+      return index->unflatten(i);
+    else
+      return index.unflatten(i);
+  }
+};
+
+} // end of namespace soil
+
+#endif
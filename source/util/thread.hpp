@@ -0,0 +1,182 @@
+#ifndef SOILLIB_UTIL_THREAD
+#define SOILLIB_UTIL_THREAD
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace soil {
+
+//! thread_pool is a persistent pool of host worker threads,
+//! which executes host-side kernels over a range of chunks.
+//!
+//! Chunks are claimed dynamically by the workers and by the
+//! calling thread, which blocks until the job is complete.
+//! Calls made from inside of a running job are executed
+//! serially, so that nested host kernels can't dead-lock.
+//!
+//! The number of threads defaults to the hardware concurrency,
+//! and can be overridden with the SOILLIB_THREADS variable.
+//!
+struct thread_pool {
+
+  thread_pool(const size_t n_threads) {
+    for (size_t n = 1; n < n_threads; ++n)
+      this->workers.emplace_back([this]() { this->work(); });
+  }
+
+  ~thread_pool() {
+    {
+      std::lock_guard lock(this->mutex);
+      this->stop = true;
+    }
+    this->cv_work.notify_all();
+    for (auto &worker : this->workers)
+      worker.join();
+  }
+
+  //! Global Host Thread Pool
+  static thread_pool &get() {
+    static thread_pool pool(thread_pool::default_size());
+    return pool;
+  }
+
+  //! Number of Threads (incl. Calling Thread)
+  size_t size() const { return this->workers.size() + 1; }
+
+  //! Execute func(k) for every chunk k in [0, n)
+  void run(const size_t n, const std::function<void(size_t)> &func) {
+
+    if (n == 0)
+      return;
+
+    if (n == 1 || this->workers.empty() || thread_pool::active()) {
+      for (size_t k = 0; k < n; ++k)
+        func(k);
+      return;
+    }
+
+    std::lock_guard job_lock(this->job_mutex); // One Job at a Time
+
+    job_t job{&func, n};
+    {
+      std::lock_guard lock(this->mutex);
+      this->job = &job;
+      ++this->generation;
+    }
+    this->cv_work.notify_all();
+    this->execute(job);
+
+    // Wait for Workers still Executing Claimed Chunks
+    std::unique_lock lock(this->mutex);
+    this->job = NULL;
+    this->cv_done.wait(lock, [&job]() { return job.users == 0; });
+
+    if (job.error)
+      std::rethrow_exception(job.error);
+  }
+
+private:
+  struct job_t {
+    const std::function<void(size_t)> *func;
+    const size_t n;
+    std::atomic<size_t> next{0}; //!< Next Unclaimed Chunk
+    size_t users = 0;            //!< Participating Workers (Guarded)
+    std::exception_ptr error;    //!< First Raised Exception (Guarded)
+  };
+
+  static size_t default_size() {
+    if (const char *env = std::getenv("SOILLIB_THREADS"))
+      return std::max(1, std::atoi(env));
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  //! Flag: Current Thread is Executing a Job
+  static bool &active() {
+    thread_local bool flag = false;
+    return flag;
+  }
+
+  void execute(job_t &job) {
+    thread_pool::active() = true;
+    for (size_t k = job.next++; k < job.n; k = job.next++) {
+      try {
+        (*job.func)(k);
+      } catch (...) {
+        std::lock_guard lock(this->mutex);
+        if (!job.error)
+          job.error = std::current_exception();
+      }
+    }
+    thread_pool::active() = false;
+  }
+
+  void work() {
+    size_t seen = 0;
+    std::unique_lock lock(this->mutex);
+    while (true) {
+      this->cv_work.wait(lock, [this, &seen]() {
+        return this->stop || this->generation != seen;
+      });
+      if (this->stop)
+        return;
+      seen = this->generation;
+      job_t *job = this->job;
+      if (job == NULL)
+        continue;
+      ++job->users;
+      lock.unlock();
+      this->execute(*job);
+      lock.lock();
+      if (--job->users == 0)
+        this->cv_done.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex job_mutex;
+  std::mutex mutex;
+  std::condition_variable cv_work;
+  std::condition_variable cv_done;
+  job_t *job = NULL;
+  size_t generation = 0;
+  bool stop = false;
+};
+
+//! parallel_chunk splits the range [0, n) into fixed-size chunks
+//! and executes func(k, start, stop) for every chunk k on the pool.
+//!
+//! Since the chunk size is fixed, the partition of the work does
+//! not depend on the number of threads, which allows for per-chunk
+//! state (e.g. accumulators, generators) to be deterministic.
+//!
+template<typename F>
+void parallel_chunk(const size_t n, const size_t chunk, F &&func) {
+  const size_t n_chunks = (n + chunk - 1) / chunk;
+  const std::function<void(size_t)> task = [&](const size_t k) {
+    const size_t start = k * chunk;
+    const size_t stop = std::min(n, start + chunk);
+    func(k, start, stop);
+  };
+  thread_pool::get().run(n_chunks, task);
+}
+
+//! parallel_for executes func(i) for every i in [0, n) on the pool.
+template<typename F>
+void parallel_for(const size_t n, F &&func, const size_t chunk = 4096) {
+  parallel_chunk(n, chunk, [&func](const size_t, const size_t start, const size_t stop) {
+    for (size_t i = start; i < stop; ++i)
+      func(i);
+  });
+}
+
+} // end of namespace soil
+
+#endif
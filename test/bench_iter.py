@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+
+import soillib as soil
+import numpy as np
+
+'''
+benchmark the host operations which iterate over buffers and indices.
+the reported times are per operation and per element, and each
+operation is measured against a baseline in the same run:
+
+- the host loop iterating through a random-access range, against
+  the same loop iterating through a yield (coroutine) generator,
+  which is kept in soil.reference for this comparison
+- buffer operations additionally against their numpy equivalent
+  (resample onto the same flat index is a copy), where one exists
+'''
+
+shape = (2048, 2048)
+index = soil.index(shape)
+elem = shape[0]*shape[1]
+
+array = np.random.ranf(shape).astype(np.float32)
+buffer = soil.buffer.from_numpy(array)
+
+def bench(func, repeat = 5):
+  timer = soil.timer(soil.us)
+  total = 0
+  for _ in range(repeat):
+    with timer:
+      func()
+    total += timer.count
+  return total/repeat
+
+def compare(name, func, ref, base = None, n = elem, repeat = 5):
+  t = bench(func, repeat)
+  r = bench(ref, repeat)
+  line = f"{name:<12} {t/1000:10.3f} ms {1000*t/n:8.3f} ns/elem"
+  line += f" {r/1000:10.3f} ms (yield) {r/t:6.2f}x"
+  if base is not None:
+    b = bench(base, repeat)
+    line += f" {b/1000:10.3f} ms (numpy) {b/t:6.2f}x"
+  print(line)
+
+# Reference Loops compute the same Result
+
+scale = (1.0, 1.0, 1.0)
+assert soil.min(buffer) == soil.reference.min(buffer)
+assert soil.max(buffer) == soil.reference.max(buffer)
+assert (soil.cast(buffer, soil.float64).numpy() == soil.reference.cast(buffer, soil.float64).numpy()).all()
+assert (soil.resample(buffer, index).numpy() == soil.reference.resample(buffer, index).numpy()).all()
+assert (soil.normal(buffer, index, scale).numpy() == soil.reference.normal(buffer, index, scale).numpy()).all()
+
+print(f"Benchmarking Host Iteration ({shape[0]}x{shape[1]})...")
+
+compare("min",
+  lambda: soil.min(buffer),
+  lambda: soil.reference.min(buffer),
+  lambda: np.min(array))
+
+compare("max",
+  lambda: soil.max(buffer),
+  lambda: soil.reference.max(buffer),
+  lambda: np.max(array))
+
+compare("cast",
+  lambda: soil.cast(buffer, soil.float64),
+  lambda: soil.reference.cast(buffer, soil.float64),
+  lambda: array.astype(np.float64))
+
+compare("resample",
+  lambda: soil.resample(buffer, index),
+  lambda: soil.reference.resample(buffer, index),
+  lambda: array.copy())
+
+compare("normal",
+  lambda: soil.normal(buffer, index, scale),
+  lambda: soil.reference.normal(buffer, index, scale))
+
+# Index Iteration from Python
+
+small = (256, 256)
+flat = soil.index(small)
+assert [tuple(p) for p in flat.iter()] == [tuple(p) for p in soil.reference.iter(flat)]
+
+compare("index.iter",
+  lambda: sum(1 for _ in flat.iter()),
+  lambda: sum(1 for _ in soil.reference.iter(flat)),
+  n = small[0]*small[1], repeat = 1)
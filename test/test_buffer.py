@@ -119,6 +119,171 @@ assert numpy.shape == (elem, 2)
 numpy[0, :] = [1, 1]
 assert buffer[0] == [1, 1]
 
+print(f"Testing Compact Types...")
+
+a = np.random.ranf(elem).astype(np.float16)
+buffer = soil.buffer.from_numpy(a)
+assert buffer.type == soil.float16
+assert buffer.size == 2*elem
+assert (buffer.numpy() == a).all()
+
+b = soil.cast(buffer, soil.float32).numpy()
+assert (b == a.astype(np.float32)).all()
+
+a = np.random.randint(0, 255, elem).astype(np.uint8)
+buffer = soil.buffer.from_numpy(a)
+assert buffer.type == soil.uint8
+assert buffer.size == elem
+soil.add(buffer, 1)
+assert (buffer.numpy() == a + 1).all()
+
+print(f"Testing Lazy Expressions...")
+
+a = np.random.ranf(elem).astype(np.float32)
+b = np.random.ranf(elem).astype(np.float32)
+a[::7] = np.nan
+
+bufferA = soil.buffer.from_numpy(a)
+bufferB = soil.buffer.from_numpy(b)
+
+expr = (soil.lazy(bufferA) + bufferB) * 2.0 - 1.0
+assert expr.type == soil.float32
+assert expr.elem == elem
+assert np.allclose(expr.eval().numpy(), (a + b) * 2.0 - 1.0, equal_nan=True)
+
+expr = soil.where(soil.lazy(bufferB) > 0.5, soil.clamp(bufferB, 0.6, 0.8), soil.fill_nan(bufferA, 0.0))
+assert np.allclose(expr.eval().numpy(), np.where(b > 0.5, np.clip(b, 0.6, 0.8), np.nan_to_num(a)))
+
+soil.set(bufferB, soil.mask(bufferB, 1.0 - soil.is_nan(bufferA)))
+assert np.isnan(bufferB.numpy()[::7]).all()
+
+print(f"Testing Statistics...")
+
+stats = soil.stats(bufferA, bins = 8, lo = 0.0, hi = 1.0)
+assert stats.nan == np.isnan(a).sum()
+assert stats.count == elem - stats.nan
+assert np.isclose(stats.min, np.nanmin(a))
+assert np.isclose(stats.max, np.nanmax(a))
+assert np.isclose(stats.mean, np.nanmean(a))
+assert np.isclose(stats.var, np.nanvar(a))
+assert stats.hist == list(np.histogram(a[~np.isnan(a)], bins = 8, range = (0.0, 1.0))[0])
+
+print(f"Testing Resize (CPU)...")
+
+a = np.random.ranf((64, 64)).astype(np.float32)
+a[:, :16] = np.nan
+bufferA = soil.buffer.from_numpy(a)
+bufferB = soil.buffer(soil.float32, 16*16)
+
+soil.resize(bufferB, bufferA, [16, 16], [64, 64], soil.area)
+b = bufferB.numpy().reshape(16, 16)
+assert np.isnan(b[:, :4]).all()
+assert np.allclose(b[:, 4:], a[:, 16:].reshape(16, 4, 12, 4).mean(axis=(1, 3)))
+
+print(f"Testing Pyramid...")
+
+a = np.random.ranf((64, 48)).astype(np.float32)
+pyramid = soil.pyramid(soil.buffer.from_numpy(a), soil.index([64, 48]))
+assert pyramid.levels == 7
+assert np.allclose(pyramid.level(2).numpy(), a.reshape(16, 4, 12, 4).mean(axis=(1, 3)))
+
+a[0:4, 0:4] = 1.0
+pyramid.level(0).numpy()[:] = a.reshape(-1)
+pyramid.invalidate([0, 0], [4, 4])
+pyramid.update()
+assert np.allclose(pyramid.level(2).numpy()[0], 1.0)
+
+print(f"Testing Memory Tracking...")
+
+soil.track_reset()
+with soil.track_scope("test"):
+  buffer = soil.buffer(soil.float32, elem)
+  with soil.track_scope("inner"):
+    bufferB = soil.buffer(soil.float64, elem)
+    del bufferB
+
+track = soil.track()
+assert track.tags["test"].current == 4*elem
+assert track.tags["test.inner"].peak == 8*elem
+assert track.tags["test.inner"].allocs == track.tags["test.inner"].frees == 1
+assert track.cpu.current == soil.mem_cpu()
+assert track.cpu.peak >= track.cpu.current
+
+print(f"Testing Archive...")
+
+import os, tempfile
+path = os.path.join(tempfile.mkdtemp(), "state.soil")
+
+a = np.random.ranf((37, 53)).astype(np.float32)
+flat = soil.buffer.from_numpy(a)
+zindex = soil.index.morton([37, 53])
+tindex = soil.index.tiled([37, 53], [8, 16])
+
+archive = soil.archive()
+archive.add("flat", flat, soil.index([37, 53]))
+archive.add("morton", soil.reorder(flat, zindex), zindex)
+archive.add("tiled", soil.reorder(flat, tindex), tindex)
+archive.meta.gdal_nodata = "-9999"
+assert archive.write(path)
+
+readonly = soil.archive(path, soil.access_t.readonly)
+assert readonly.names() == ["flat", "morton", "tiled"]
+assert readonly.meta.gdal_nodata == "-9999"
+assert readonly.buffer("flat").readonly
+assert not readonly.buffer("flat").numpy().flags.writeable
+assert (readonly.buffer("flat").numpy() == a.reshape(-1)).all()
+assert readonly.index("morton").type == soil.morton
+assert readonly.index("tiled").type == soil.tiled2
+assert readonly.index("tiled").elem() == tindex.elem()
+assert (readonly.buffer("morton").numpy(zindex).flatten() == a.reshape(-1)).all()
+assert (readonly.buffer("tiled").numpy(tindex).flatten() == a.reshape(-1)).all()
+
+cow = soil.archive(path)
+buffer = cow.buffer("flat")
+assert not buffer.readonly
+buffer.numpy()[0] = 42.0 # Private Copy of the Page
+assert buffer[0] == 42.0
+assert soil.archive(path).buffer("flat")[0] == a.reshape(-1)[0]
+
+# Rewrite over the File the Buffers were Loaded From
+cow.add("flat", soil.buffer.from_numpy(2.0*a), soil.index([37, 53]))
+assert cow.write(path)
+assert buffer[0] == 42.0 and (readonly.buffer("flat").numpy() == a.reshape(-1)).all()
+assert (soil.archive(path).buffer("flat").numpy() == 2.0*a.reshape(-1)).all()
+
+print(f"Testing File-Backed Buffers...")
+
+tmp = tempfile.mkdtemp()
+path = os.path.join(tmp, "mapped.bin")
+
+mapped = soil.buffer.mapped(soil.float32, elem, path)
+mapped.numpy()[:] = np.arange(elem, dtype = np.float32)
+del mapped # Unmapped, the File is Kept
+assert (np.fromfile(path, dtype = np.float32) == np.arange(elem, dtype = np.float32)).all()
+
+mapped = soil.buffer.mapped(soil.float32, elem, path) # Existing File: Contents Kept
+assert mapped[7] == 7.0
+del mapped
+
+mapped = soil.buffer.mapped(soil.float32, elem) # Unlinked Temporary File
+mapped.numpy()[:] = 3.0
+assert (mapped.numpy() == 3.0).all()
+del mapped
+
+# Allocation Policy: New CPU Buffers are File-Backed, not Counted
+cpu = soil.mem_cpu()
+with soil.map_scope(tmp, soil.advice.sequential):
+  mapped = soil.buffer(soil.float32, elem)
+  mapped.numpy()[:] = 5.0
+  assert soil.mem_cpu() == cpu
+assert os.listdir(tmp) == ["mapped.bin"] # Temporary Files are Unlinked
+assert (mapped.numpy() == 5.0).all()
+del mapped
+
+buffer = soil.buffer(soil.float32, elem)
+assert soil.mem_cpu() == cpu + 4*elem
+del buffer
+
 print(f"Testing GPU Methods...")
 
 buffer = soil.buffer(soil.float64, elem).gpu()
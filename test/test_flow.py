@@ -0,0 +1,131 @@
+#!/usr/bin/env python
+
+import soillib as soil
+import numpy as np
+
+'''
+test the flow operations (conditioning, flow graph queries) against
+numpy references on small synthetic height-maps.
+'''
+
+# D8 Neighborhood: Flow Code -> Offset (see flow.hpp dirmap)
+
+offsets = {7: (-1, 0), 8: (-1, 1), 1: (0, 1), 2: (1, 1), 3: (1, 0), 4: (1, -1), 5: (0, -1), 6: (-1, -1)}
+
+def neighbors(array, fill):
+  '''8 neighbor arrays of a 2D array, filled outside of the domain'''
+  pad = np.pad(array, 1, constant_values = fill)
+  h, w = array.shape
+  return [pad[1+dx:1+dx+h, 1+dy:1+dy+w] for dx, dy in offsets.values()]
+
+print("Testing soil.condition...")
+
+shape = (32, 32)
+r, c = np.indices(shape)
+dem = (r + c).astype(np.float32) # Drains to the Upper-Left Boundary
+
+pit = (slice(10, 15), slice(10, 15))
+flat = (slice(20, 27), slice(3, 10))
+hole = (slice(5, 8), slice(25, 28))
+dem[pit] -= 20.0 # Depression, Spills at 18
+dem[flat] = 23.0
+dem[hole] = np.nan
+
+index = soil.index(list(shape))
+cond = soil.condition(soil.buffer.from_numpy(dem), index).numpy().reshape(shape)
+
+valid = ~np.isnan(dem)
+assert (np.isnan(cond) == ~valid).all()
+assert (cond[valid] >= dem[valid]).all()
+
+# Every Non-Outlet Cell has a strictly lower D8 Neighbor
+
+outlet = np.zeros(shape, dtype = bool)
+outlet[0, :] = outlet[-1, :] = outlet[:, 0] = outlet[:, -1] = True
+for n in neighbors(dem, 0.0):
+  outlet |= np.isnan(n)
+
+lower = np.zeros(shape, dtype = bool)
+for n in neighbors(cond, np.nan):
+  lower |= (n < cond) # Note: NaN compares False
+
+assert lower[valid & ~outlet].all()
+
+# Cells outside of the Depression and Flat are not raised
+
+raised = np.zeros(shape, dtype = bool)
+raised[pit] = raised[flat] = True
+assert (cond[valid & ~raised] == dem[valid & ~raised]).all()
+assert (cond[pit] > 18.0).all()
+assert (cond[flat] >= 23.0).all() and (cond[flat] < 24.0).all()
+
+print("Testing soil.flow_graph...")
+
+shape = (64, 64)
+elem = shape[0]*shape[1]
+index = soil.index(list(shape))
+
+height = np.random.ranf(shape).astype(np.float32)
+height += np.indices(shape).sum(axis = 0) / 32.0 # Long Flow Paths
+code = soil.flow(soil.buffer.from_numpy(height), index)
+direction = soil.direction(code, index)
+graph = soil.flow_graph(direction, index)
+
+# Reference Successor: Flat Index of the Downstream Cell (or Self)
+
+code = code.cpu().numpy().reshape(shape)
+succ = np.arange(elem).reshape(shape)
+for k, (dx, dy) in offsets.items():
+  x, y = np.nonzero(code == k)
+  inside = (x + dx >= 0) & (x + dx < shape[0]) & (y + dy >= 0) & (y + dy < shape[1])
+  succ[x[inside], y[inside]] = (x[inside] + dx)*shape[1] + (y[inside] + dy)
+succ = succ.reshape(-1)
+
+def path(i):
+  '''cells on the flow path from cell i, incl. i and the outlet'''
+  cells = [i]
+  while succ[cells[-1]] != cells[-1]:
+    cells.append(succ[cells[-1]])
+  return cells
+
+paths = [path(i) for i in range(elem)]
+
+# Exhaustive Accumulation: Number of Paths through every Cell
+
+area = np.zeros(elem)
+for p in paths:
+  area[p] += 1.0
+assert (soil.accumulation_exhaustive(graph).numpy() == area).all()
+assert (soil.accumulation_exhaustive(direction.cpu(), index).numpy() == area).all()
+assert (soil.accumulation_exhaustive(direction, index).cpu().numpy() == area).all() # GPU
+
+# Upstream and Distance per Target, against the Flow Paths
+
+targets = [int(t) for t in np.argsort(area)[-4:]] # Largest Catchments
+targets += [int(succ[targets[0]]), 5*shape[1] + 7] # Nested Outlet, Small Catchment
+positions = [[t // shape[1], t % shape[1]] for t in targets]
+
+steps = {}
+for t, pos in zip(targets, positions):
+  ref = np.array([p.index(t) if t in p else -1 for p in paths])
+  steps[t] = ref
+  assert (soil.distance(graph, pos).numpy() == ref).all()
+  assert (soil.upstream(graph, pos).numpy() == (ref > 0)).all()
+  assert area[t] == (ref >= 0).sum()
+
+# Catchments: Nearest Downstream Outlet, against the per-Target Distances
+
+label, dist = soil.catchments(graph, positions)
+label = label.numpy()
+dist = dist.numpy()
+
+for i, p in enumerate(paths):
+  hit = [(p.index(t), k) for k, t in enumerate(targets) if t in p]
+  if not hit:
+    assert label[i] == -1 and dist[i] == -1
+    continue
+  step, k = min(hit)
+  assert label[i] == k and dist[i] == step == steps[targets[k]][i]
+
+label_b, dist_b = soil.catchments(direction, index, positions)
+assert (label_b.numpy() == label).all() and (dist_b.numpy() == dist).all()
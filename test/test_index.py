@@ -101,6 +101,69 @@ for pos in shape.iter():
   i += 1
 assert i == shape.elem()
 
+print(f"Testing soil.index({soil.morton})...")
+
+array = [32, 32]
+shape = soil.index.morton(array)
+
+assert shape.type == soil.morton
+assert shape.dims() == 2
+assert shape.elem() == array[0]*array[1]
+
+assert not shape.oob(shape.min())
+assert shape.oob(shape.max())
+
+i = 0
+for pos in shape.iter():
+  assert not shape.oob(pos)
+  assert shape.flatten(pos) == i
+  i += 1
+assert i == shape.elem()
+
+flat = soil.buffer.from_numpy(np.arange(32*32, dtype=np.float32).reshape(32, 32))
+zorder = soil.reorder(flat, shape)
+assert (zorder.numpy(shape).flatten() == flat.numpy()).all()
+
+assert soil.index.morton([1025, 1025]).elem() < 3*1025*1025
+try:
+  soil.index.morton([40000, 100]) # Excessive Padding
+  assert False
+except ValueError:
+  pass
+
+print(f"Testing soil.index({soil.tiled2})...")
+
+array = [37, 53]
+shape = soil.index.tiled(array, [8, 16])
+
+assert shape.type == soil.tiled2
+assert shape.dims() == 2
+assert shape.elem() == 5*4*8*16 # Padded Edge Tiles
+
+assert not shape.oob(shape.min())
+assert shape.oob(shape.max())
+
+i = 0
+last = -1
+for pos in shape.iter():
+  assert not shape.oob(pos)
+  assert shape.flatten(pos) > last
+  last = shape.flatten(pos)
+  i += 1
+assert i == array[0]*array[1]
+assert len(shape.iter()) == array[0]*array[1]
+
+flat = soil.buffer.from_numpy(np.arange(37*53, dtype=np.float32).reshape(37, 53))
+tiled = soil.reorder(flat, shape)
+assert (tiled.numpy(shape).flatten() == flat.numpy()).all()
+
+for tile in [[0, 16], [8, -1]]:
+  try:
+    soil.index.tiled(array, tile)
+    assert False
+  except ValueError:
+    pass
+
 print(f"Testing soil.index({soil.quad})...")
 
 array = [
@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+
+import soillib as soil
+import numpy as np
+import os
+import tempfile
+
+'''
+test the file formats (tiff, geotiff, mosaic) against numpy
+'''
+
+tmp = tempfile.mkdtemp()
+
+def geotiff(array, x0, y0):
+  g = soil.geotiff(soil.buffer.from_numpy(np.ascontiguousarray(array)), soil.index(list(array.shape)))
+  g.meta.scale = [2.0, 3.0, 0.0]
+  g.meta.coords = [0.0, 0.0, 0.0, x0, y0, 0.0]
+  return g
+
+print(f"Testing soil.mosaic...")
+
+full = np.random.ranf((300, 500)).astype(np.float32)
+
+# Two Adjacent Stripped Tiles and a Tiled Source
+
+files = []
+for k, (c0, c1, tile) in enumerate([(0, 200, 0), (200, 400, 0), (400, 500, 64)]):
+  options = soil.tiff_options()
+  options.tile = tile
+  files.append(os.path.join(tmp, f"mosaic{k}.tif"))
+  geotiff(full[:, c0:c1], 1000.0 + 2.0*c0, 9000.0).write(files[-1], options)
+
+mosaic = soil.mosaic(files)
+assert mosaic.size == 3
+assert mosaic.ext == [300, 500]
+
+for repeat in range(2): # Cold and Cached
+  window = mosaic.read([1000.0 + 2.0*150, 9000.0 - 3.0*250], [1000.0 + 2.0*450, 9000.0 - 3.0*50])
+  assert window.height == 200 and window.width == 300
+  assert (window.buffer.numpy().reshape(200, 300) == full[50:250, 150:450]).all()
+
+print(f"Testing soil.tiff Writer Options...")
+
+data = {
+  np.float32: np.random.ranf((200, 157)).astype(np.float32),
+  np.float16: np.random.ranf((200, 157)).astype(np.float16),
+  np.int16: np.random.randint(-30000, 30000, (200, 157)).astype(np.int16),
+}
+data[np.float32][::7, ::5] = np.nan
+data[np.float16][::7, ::5] = np.nan
+
+for dtype, array in data.items():
+  for tile in [0, 64]:
+    for compress in [soil.compress_t.none, soil.compress_t.lzw, soil.compress_t.deflate, soil.compress_t.zstd]:
+      for predictor in [False, True]:
+        options = soil.tiff_options()
+        options.tile = tile
+        options.compress = compress
+        options.predictor = predictor
+        filename = os.path.join(tmp, "options.tif")
+        try:
+          soil.tiff(soil.buffer.from_numpy(array), soil.index(list(array.shape))).write(filename, options)
+        except ValueError: # Codec not configured in libtiff
+          assert compress == soil.compress_t.zstd
+          continue
+        read = soil.tiff(filename).buffer.numpy().reshape(array.shape)
+        assert read.dtype == array.dtype
+        assert read.tobytes() == array.tobytes() # Bit-Identical (incl. NaN)
+
+print(f"Testing soil.tiff Windowed Read...")
+
+full = np.random.ranf((300, 157)).astype(np.float32)
+big = 2**31 - 1 # min + ext Overflows 32-bit
+
+windows = [
+  ([0, 0], [300, 157]),
+  ([50, 30], [100, 64]),
+  ([250, 120], [100, 100]), # Clipped at the End
+  ([-10, -20], [40, 50]),   # Clipped at the Origin
+  ([17, 3], [big, big]),    # Until the End
+  ([-5, -5], [big, big]),
+]
+
+for tile in [0, 64]: # Stripped and Tiled
+  options = soil.tiff_options()
+  options.tile = tile
+  filename = os.path.join(tmp, "window.tif")
+  geotiff(full, 1000.0, 9000.0).write(filename, options)
+
+  for wmin, wext in windows:
+    r0, c0 = [min(max(m, 0), n) for m, n in zip(wmin, full.shape)]
+    r1, c1 = [min(max(m + e, k), n) for m, e, k, n in zip(wmin, wext, (r0, c0), full.shape)]
+
+    t = soil.tiff()
+    t.read(filename, wmin, wext)
+    assert t.height == r1 - r0 and t.width == c1 - c0
+    assert (t.buffer.numpy().reshape(r1 - r0, c1 - c0) == full[r0:r1, c0:c1]).all()
+
+    g = soil.geotiff()
+    g.read(filename, wmin, wext)
+    assert (g.buffer.numpy().reshape(r1 - r0, c1 - c0) == full[r0:r1, c0:c1]).all()
+    assert g.meta.coords[3] == 1000.0 + 2.0*c0 # Tie Point at the Window Origin
+    assert g.meta.coords[4] == 9000.0 - 3.0*r0
+
+  for wmin, wext in [([300, 0], [10, 10]), ([0, 0], [0, 10]), ([-20, 0], [10, 10])]:
+    try:
+      soil.tiff().read(filename, wmin, wext)
+      assert False
+    except ValueError: # Window does not intersect the Image
+      pass
+
+print(f"Testing soil.geotiff Overviews...")
+
+def reduce(array, nodata):
+  h, w = (array.shape[0] + 1)//2, (array.shape[1] + 1)//2
+  pad = np.full((2*h, 2*w), nodata, dtype = np.float64)
+  pad[:array.shape[0], :array.shape[1]] = array
+  blocks = pad.reshape(h, 2, w, 2).transpose(0, 2, 1, 3).reshape(h, w, 4)
+  valid = blocks != nodata
+  count = valid.sum(axis = 2)
+  mean = np.where(valid, blocks, 0.0).sum(axis = 2) / np.maximum(count, 1)
+  return mean, count
+
+for dtype in [np.float32, np.int16]:
+  array = np.random.randint(0, 1000, (37, 53)).astype(dtype)
+  array[0:4, 0:6] = -9999 # Fully NoData Cells
+  array[::3, ::7] = -9999
+  g = geotiff(array, 1000.0, 9000.0)
+  g.meta.gdal_nodata = "-9999"
+  options = soil.tiff_options()
+  options.overviews = 2
+  filename = os.path.join(tmp, "overviews.tif")
+  g.write(filename, options)
+
+  level = soil.geotiff()
+  level.read(filename, 1)
+  assert level.height == 19 and level.width == 27
+  assert np.allclose(level.scale, [2.0*53/27, 3.0*37/19])
+  assert np.allclose(level.min, g.min) and np.allclose(level.max, g.max)
+
+  mean, count = reduce(array, -9999)
+  read = level.buffer.numpy().reshape(19, 27)
+  if dtype == np.float32:
+    assert np.isnan(read[count == 0]).all()
+    assert (read[count > 0] == mean[count > 0].astype(np.float32)).all()
+  else:
+    assert (read[count == 0] == -9999).all()
+    assert (read[count > 0] == np.floor(mean[count > 0] + 0.5)).all()